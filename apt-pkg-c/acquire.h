@@ -22,6 +22,10 @@ struct PkgAcquire {
 
 	UniquePtr<std::vector<AcqWorker>> workers() const;
 
+	/// The number of workers, and how many of them have an item, without copying them.
+	u32 worker_count() const;
+	u32 busy_workers() const;
+
 	PkgAcquire() : ptr(new pkgAcquire), del(true){};
 	PkgAcquire(pkgAcquire* base) : ptr(base), del(false){};
 	~PkgAcquire() {
@@ -32,16 +36,19 @@ struct PkgAcquire {
 struct Item {
 	pkgAcquire::Item* ptr;
 
-	u32 id() const { return ptr->ID; }
-	bool complete() const { return ptr->Complete; }
-	u64 file_size() const { return ptr->FileSize; }
-	ItemState status() const { return ptr->Status; }
-	String uri() const { return ptr->DescURI(); }
-	String dest_file() const { return ptr->DestFile; }
-	String error_text() const { return ptr->ErrorText; }
-	String active_subprocess() const { return ptr->ActiveSubprocess; }
-
-	UniquePtr<PkgAcquire> owner() const { return std::make_unique<PkgAcquire>(ptr->GetOwner()); }
+	u32 id() const { RUST_APT_CALL(); return ptr->ID; }
+	bool complete() const { RUST_APT_CALL(); return ptr->Complete; }
+	u64 file_size() const { RUST_APT_CALL(); return ptr->FileSize; }
+	ItemState status() const { RUST_APT_CALL(); return ptr->Status; }
+	String uri() const { RUST_APT_CALL(); return new_string(ptr->DescURI()); }
+	String dest_file() const { RUST_APT_CALL(); return new_string(ptr->DestFile); }
+	String error_text() const { RUST_APT_CALL(); return new_string(ptr->ErrorText); }
+	String active_subprocess() const { RUST_APT_CALL(); return new_string(ptr->ActiveSubprocess); }
+
+	UniquePtr<PkgAcquire> owner() const {
+		RUST_APT_CALL();
+		return new_unique<PkgAcquire>(ptr->GetOwner());
+	}
 
 	Item(pkgAcquire::Item* base) : ptr(base){};
 };
@@ -49,11 +56,11 @@ struct Item {
 struct ItemDesc {
 	pkgAcquire::ItemDesc* ptr;
 
-	String uri() const { return ptr->URI; }
-	String description() const { return ptr->Description; }
-	String short_desc() const { return ptr->ShortDesc; }
+	String uri() const { RUST_APT_CALL(); return new_string(ptr->URI); }
+	String description() const { RUST_APT_CALL(); return new_string(ptr->Description); }
+	String short_desc() const { RUST_APT_CALL(); return new_string(ptr->ShortDesc); }
 
-	UniquePtr<Item> owner() const { return std::make_unique<Item>(ptr->Owner); }
+	UniquePtr<Item> owner() const { RUST_APT_CALL(); return new_unique<Item>(ptr->Owner); }
 
 	// Cast away the constness in this case. We aren't going to change it.
 	ItemDesc(const pkgAcquire::ItemDesc* base) : ptr(const_cast<pkgAcquire::ItemDesc*>(base)){};
@@ -64,13 +71,14 @@ struct AcqWorker {
 	pkgAcquire::Worker* ptr;
 	pkgAcquire::ItemDesc* item_desc;
 
-	String status() const { return ptr->Status; }
-	u64 current_size() const { return ptr->CurrentItem->CurrentSize; }
-	u64 total_size() const { return ptr->CurrentItem->TotalSize; }
+	String status() const { RUST_APT_CALL(); return new_string(ptr->Status); }
+	u64 current_size() const { RUST_APT_CALL(); return ptr->CurrentItem->CurrentSize; }
+	u64 total_size() const { RUST_APT_CALL(); return ptr->CurrentItem->TotalSize; }
 
 	UniquePtr<ItemDesc> item() const {
-		if (ptr->CurrentItem == 0) { throw std::runtime_error("Null Item!"); }
-		return std::make_unique<ItemDesc>(item_desc);
+		RUST_APT_CALL();
+		if (ptr->CurrentItem == 0) { RUST_APT_THROW("Null Item!"); }
+		return new_unique<ItemDesc>(item_desc);
 	}
 
 	AcqWorker(pkgAcquire::Worker* base) : ptr(base), item_desc(base->CurrentItem){};
@@ -195,34 +203,54 @@ struct AcqTextStatus : public pkgAcquireStatus {
 
 	void set_callback(AcquireProgress* callback) { this->callback = callback; };
 
-	u64 current_cps() const { return this->CurrentCPS; }
-	u64 elapsed_time() const { return this->ElapsedTime; }
-	u64 fetched_bytes() const { return this->FetchedBytes; }
-	u64 current_bytes() const { return this->CurrentBytes; }
-	u64 total_bytes() const { return this->TotalBytes; }
-	f64 percent() const { return this->Percent; }
+	u64 current_cps() const { RUST_APT_CALL(); return this->CurrentCPS; }
+	u64 elapsed_time() const { RUST_APT_CALL(); return this->ElapsedTime; }
+	u64 fetched_bytes() const { RUST_APT_CALL(); return this->FetchedBytes; }
+	u64 current_bytes() const { RUST_APT_CALL(); return this->CurrentBytes; }
+	u64 total_bytes() const { RUST_APT_CALL(); return this->TotalBytes; }
+	f64 percent() const { RUST_APT_CALL(); return this->Percent; }
 
 	AcqTextStatus() : pkgAcquireStatus(), callback(0){};
 };
 
 inline UniquePtr<std::vector<ItemDesc>> PkgAcquire::uris() const {
+	RUST_APT_CALL();
 	std::vector<ItemDesc> list;
 
 	pkgAcquire::UriIterator I = ptr->UriBegin();
 	for (; I != ptr->UriEnd(); ++I) {
 		list.push_back(ItemDesc(I.operator->()));
 	}
-	return std::make_unique<std::vector<ItemDesc>>(list);
+	return new_unique<std::vector<ItemDesc>>(list);
 }
 
 inline UniquePtr<std::vector<AcqWorker>> PkgAcquire::workers() const {
+	RUST_APT_CALL();
 	std::vector<AcqWorker> list;
 
 	for (pkgAcquire::Worker* I = ptr->WorkersBegin(); I != 0; I = ptr->WorkerStep(I)) {
 		list.push_back(I);
 	}
-	return std::make_unique<std::vector<AcqWorker>>(list);
+	return new_unique<std::vector<AcqWorker>>(list);
+}
+
+inline u32 PkgAcquire::worker_count() const {
+	RUST_APT_CALL();
+	u32 count = 0;
+	for (pkgAcquire::Worker* I = ptr->WorkersBegin(); I != 0; I = ptr->WorkerStep(I)) {
+		count++;
+	}
+	return count;
+}
+
+inline u32 PkgAcquire::busy_workers() const {
+	RUST_APT_CALL();
+	u32 count = 0;
+	for (pkgAcquire::Worker* I = ptr->WorkersBegin(); I != 0; I = ptr->WorkerStep(I)) {
+		if (I->CurrentItem != 0) { count++; }
+	}
+	return count;
 }
 
-inline UniquePtr<AcqTextStatus> acquire_status() { return std::make_unique<AcqTextStatus>(); }
-inline UniquePtr<PkgAcquire> create_acquire() { return std::make_unique<PkgAcquire>(); }
+inline UniquePtr<AcqTextStatus> acquire_status() { return new_unique<AcqTextStatus>(); }
+inline UniquePtr<PkgAcquire> create_acquire() { return new_unique<PkgAcquire>(); }
@@ -1,5 +1,6 @@
 #pragma once
 #include <apt-pkg/cachefile.h>
+#include <apt-pkg/configuration.h>
 #include <apt-pkg/debfile.h>
 #include <apt-pkg/error.h>
 #include <apt-pkg/fileutl.h>
@@ -8,82 +9,363 @@
 #include <apt-pkg/policy.h>
 #include <apt-pkg/sourcelist.h>
 #include <apt-pkg/update.h>
+#include <sys/stat.h>
+#include <cstring>
+#include <string>
+#include <unordered_map>
 #include "rust/cxx.h"
 
 // Defines the callbacks code that's generated for progress
 #include "rust-apt/src/acquire.rs"
+// Defines the shared PackageColumns struct
+#include "rust-apt/src/cache.rs"
 
 #include "depcache.h"
 #include "records.h"
 #include "types.h"
 
+/// Every version in the cache by "name:arch=version", see `PkgCacheFile::version_index`.
+struct VersionIndex {
+	std::unordered_map<std::string, u64> versions;
+	std::string native_arch;
+
+	/// The index of the version for a "name=version" or "name:arch=version" spec, 0 if there is
+	/// none.
+	u64 find(str spec) const {
+		RUST_APT_CALL();
+		std::string key(spec);
+		size_t eq = key.find('=');
+		if (eq == std::string::npos) { return 0; }
+
+		// Any colon after the '=' is an epoch, not an architecture.
+		if (key.find(':') > eq) { key.insert(eq, ":" + native_arch); }
+
+		auto it = versions.find(key);
+		return it == versions.end() ? 0 : it->second;
+	}
+
+	/// `find` for every spec.
+	Vec<u64> find_many(Slice<const str> specs) const {
+		RUST_APT_CALL();
+		Vec<u64> list;
+		list.reserve(specs.size());
+		for (const str& spec : specs) { list.push_back(find(spec)); }
+		return list;
+	}
+};
+
 struct PkgCacheFile : public pkgCacheFile {
 	// Maybe we use this if we don't want pin_mut() all over the place in Rust.
 	PkgCacheFile* unconst() const { return const_cast<PkgCacheFile*>(this); }
 
 	/// Update the package lists, handle errors and return a Result.
 	void update(AcqTextStatus& progress) const {
+		RUST_APT_CALL();
 		ListUpdate(
 			progress, *this->unconst()->GetSourceList(), progress.callback->pulse_interval()
 		);
-		handle_errors();
+		RUST_APT_HANDLE_ERRORS();
 	}
 
 	// Return a package by name.
 	UniquePtr<PkgIterator> find_pkg(str name) const {
-		return std::make_unique<PkgIterator>(
+		RUST_APT_CALL();
+		return new_unique<PkgIterator>(
 			this->unconst()->GetPkgCache()->FindPkg(APT::StringView(name.begin(), name.length()))
 		);
 	}
 
 	UniquePtr<PkgIterator> begin() const {
-		return std::make_unique<PkgIterator>(this->unconst()->GetPkgCache()->PkgBegin());
+		RUST_APT_CALL();
+		return new_unique<PkgIterator>(this->unconst()->GetPkgCache()->PkgBegin());
+	}
+
+	/// Rebuild a package from the offset returned by `PkgIterator::Index`.
+	UniquePtr<PkgIterator> find_pkg_by_index(u64 index) const {
+		RUST_APT_CALL();
+		pkgCache* cache = this->unconst()->GetPkgCache();
+		return new_unique<PkgIterator>(pkgCache::PkgIterator(*cache, cache->PkgP + index));
+	}
+
+	/// Rebuild a version from the offset returned by `VerIterator::Index`.
+	UniquePtr<VerIterator> find_ver_by_index(u64 index) const {
+		RUST_APT_CALL();
+		pkgCache* cache = this->unconst()->GetPkgCache();
+		return new_unique<VerIterator>(pkgCache::VerIterator(*cache, cache->VerP + index));
+	}
+
+	/// Map every version of every package by "name:arch=version".
+	///
+	/// When a package has the same version string more than once, the first in its version list
+	/// is kept.
+	UniquePtr<VersionIndex> version_index() const {
+		RUST_APT_CALL();
+		pkgCache* cache = this->unconst()->GetPkgCache();
+		UniquePtr<VersionIndex> index = new_unique<VersionIndex>();
+		index->native_arch = cache->NativeArch();
+		index->versions.reserve(cache->Head().VersionCount);
+
+		for (pkgCache::PkgIterator pkg = cache->PkgBegin(); !pkg.end(); pkg++) {
+			std::string prefix = pkg.FullName(false) + "=";
+			for (pkgCache::VerIterator ver = pkg.VersionList(); !ver.end(); ver++) {
+				index->versions.emplace(prefix + ver.VerStr(), ver.Index());
+			}
+		}
+		return index;
+	}
+
+	/// A hash of what apt checks to decide whether the cache is still valid:
+	/// the cache counts and the name, size and mtime of every package file.
+	u64 fingerprint() const {
+		RUST_APT_CALL();
+		pkgCache* cache = this->unconst()->GetPkgCache();
+		const pkgCache::Header& head = cache->Head();
+
+		// FNV-1a
+		u64 hash = 14695981039346656037ULL;
+		auto mix = [&hash](const void* data, size_t len) {
+			const unsigned char* bytes = static_cast<const unsigned char*>(data);
+			for (size_t i = 0; i < len; i++) {
+				hash ^= bytes[i];
+				hash *= 1099511628211ULL;
+			}
+		};
+
+		u64 counts[] = {
+			head.PackageCount,
+			head.VersionCount,
+			head.DependsCount,
+			head.ProvidesCount,
+			head.PackageFileCount,
+		};
+		mix(counts, sizeof(counts));
+
+		for (pkgCache::PkgFileIterator file = cache->FileBegin(); !file.end(); file++) {
+			const char* name = file.FileName();
+			if (name != nullptr) { mix(name, strlen(name)); }
+			u64 stat[] = {u64(file->Size), u64(file->mtime)};
+			mix(stat, sizeof(stat));
+		}
+		return hash;
+	}
+
+	/// The index of every package, in the same order as `begin`.
+	Vec<u64> package_indexes() const {
+		RUST_APT_CALL();
+		pkgCache* cache = this->unconst()->GetPkgCache();
+		Vec<u64> list;
+		list.reserve(cache->Head().PackageCount);
+		for (pkgCache::PkgIterator it = cache->PkgBegin(); !it.end(); it++) {
+			list.push_back(it.Index());
+		}
+		return list;
+	}
+
+	/// The index of every version, package by package.
+	Vec<u64> version_indexes() const {
+		RUST_APT_CALL();
+		pkgCache* cache = this->unconst()->GetPkgCache();
+		Vec<u64> list;
+		list.reserve(cache->Head().VersionCount);
+		for (pkgCache::PkgIterator pkg = cache->PkgBegin(); !pkg.end(); pkg++) {
+			for (pkgCache::VerIterator ver = pkg.VersionList(); !ver.end(); ver++) {
+				list.push_back(ver.Index());
+			}
+		}
+		return list;
+	}
+
+	/// Walk every package once and gather its data into columns.
+	PackageColumns package_columns() const {
+		RUST_APT_CALL();
+		pkgCache* cache = this->unconst()->GetPkgCache();
+		pkgDepCache* depcache = this->unconst()->GetDepCache();
+		PkgDepCache state(depcache);
+		PackageColumns cols;
+
+		size_t count = cache->Head().PackageCount;
+		cols.index.reserve(count);
+		cols.name_offsets.reserve(count + 1);
+		cols.arch.reserve(count);
+		cols.current_ver.reserve(count);
+		cols.candidate_ver.reserve(count);
+		cols.flags.reserve(count);
+
+		std::string names;
+		// There are only ever a handful of architectures, a scan is cheaper than a map.
+		std::vector<const char*> arches;
+
+		for (pkgCache::PkgIterator it = cache->PkgBegin(); !it.end(); it++) {
+			PkgIterator pkg(it);
+			const char* arch = it.Arch();
+
+			size_t arch_id = 0;
+			while (arch_id < arches.size() && strcmp(arches[arch_id], arch) != 0) { arch_id++; }
+			if (arch_id == arches.size()) {
+				arches.push_back(arch);
+				cols.arches.push_back(String(arch));
+			}
+
+			cols.index.push_back(it.Index());
+			cols.name_offsets.push_back(names.size());
+			names.append(it.Name());
+			cols.arch.push_back(arch_id);
+			cols.current_ver.push_back(it.CurrentVer().Index());
+			cols.candidate_ver.push_back((*depcache)[it].CandidateVerIter(*depcache).Index());
+			cols.flags.push_back(state.state_flags(pkg));
+		}
+
+		cols.name_offsets.push_back(names.size());
+		cols.names = String(names);
+		return cols;
 	}
 
 	/// The priority of the package as shown in `apt policy`.
 	int32_t priority(const VerIterator& ver) const {
+		RUST_APT_CALL();
 		return this->unconst()->GetPolicy()->GetPriority(ver);
 	}
 
 	UniquePtr<PkgDepCache> create_depcache() const {
-		return std::make_unique<PkgDepCache>(this->unconst()->GetDepCache());
+		RUST_APT_CALL();
+		return new_unique<PkgDepCache>(this->unconst()->GetDepCache());
+	}
+
+	/// A DepCache of its own over the same cache and policy, starting with the marks of the
+	/// shared one.
+	UniquePtr<PkgDepCache> fork_depcache() const {
+		RUST_APT_CALL();
+		pkgCacheFile* file = this->unconst();
+		UniquePtr<PkgDepCache> fork = new_unique<PkgDepCache>(
+			new pkgDepCache(file->GetPkgCache(), file->GetPolicy()), true
+		);
+
+		fork->ptr->Init(nullptr);
+		RUST_APT_HANDLE_ERRORS();
+		fork->restore(PkgDepCache(file->GetDepCache()).checkpoint()->states);
+		return fork;
 	}
 
 	UniquePtr<PkgRecords> create_records() const {
-		return std::make_unique<PkgRecords>(this->unconst());
+		RUST_APT_CALL();
+		return new_unique<PkgRecords>(this->unconst());
 	}
 
 	UniquePtr<IndexFile> find_index(const PkgFileIterator& file) const {
+		RUST_APT_CALL();
 		pkgIndexFile* index;
 		if (!this->unconst()->GetSourceList()->FindIndex(file, index)) {
 			_system->FindIndex(file, index);
 		}
-		return std::make_unique<IndexFile>(index);
+		return new_unique<IndexFile>(index);
 	}
 
 	bool get_indexes(const PkgAcquire& fetcher) const {
+		RUST_APT_CALL();
 		return this->unconst()->GetSourceList()->GetIndexes(fetcher.ptr, true);
 	}
 
+	/// Map `pkgcache.bin` as it is, without checking it against the index files.
+	///
+	/// Returns false and leaves no errors behind if the file can't be used.
+	bool open_trusted() {
+		const char* key = "pkgCacheFile::Generate";
+		bool was_set = _config->Exists(key);
+		std::string previous = _config->Find(key);
+
+		_error->PushToStack();
+		// With Generate off apt maps the existing file instead of building one.
+		_config->Set(key, "false");
+		bool opened = this->GetPkgCache() != nullptr && !_error->PendingError();
+
+		if (was_set) {
+			_config->Set(key, previous);
+		} else {
+			_config->Clear(key);
+		}
+
+		if (!opened) {
+			this->Close();
+			_error->RevertToStack();
+			return false;
+		}
+		_error->MergeWithStack();
+		return true;
+	}
+
 	PkgCacheFile() : pkgCacheFile(){};
 };
 
-inline UniquePtr<PkgCacheFile> create_cache(rust::Slice<const str> volatile_files) {
-	UniquePtr<PkgCacheFile> cache = std::make_unique<PkgCacheFile>();
+/// True if nothing the package cache is built from changed after `pkgcache.bin` was written.
+///
+/// This only compares mtimes, it is meant to be far cheaper than the checks apt does.
+inline bool pkgcache_is_fresh() {
+	std::string pkgcache = _config->FindFile("Dir::Cache::pkgcache");
+	struct stat cache_stat;
+	if (pkgcache.empty() || stat(pkgcache.c_str(), &cache_stat) != 0) { return false; }
 
+	std::string parts = _config->FindDir("Dir::Etc::sourceparts");
+	std::vector<std::string> inputs = {
+		_config->FindFile("Dir::State::status"),
+		_config->FindDir("Dir::State::lists"),
+		_config->FindFile("Dir::Etc::sourcelist"),
+		_config->FindFile("Dir::Cache::srcpkgcache"),
+		parts,
+	};
+
+	// Editing a file in place doesn't touch the mtime of its directory.
+	if (DirectoryExists(parts)) {
+		for (auto& file : GetListOfFilesInDir(parts, {"list", "sources"}, false)) {
+			inputs.push_back(file);
+		}
+	}
+
+	for (auto& input : inputs) {
+		struct stat input_stat;
+		if (!input.empty() && stat(input.c_str(), &input_stat) == 0 &&
+			input_stat.st_mtime >= cache_stat.st_mtime) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/// Add the volatile files to the cache's source list.
+inline void add_volatile_files(PkgCacheFile& cache, rust::Slice<const str> volatile_files) {
 	for (auto file_str : volatile_files) {
 		std::string file_string(file_str);
 		// Add the file to the cache.
-		if (!cache->GetSourceList()->AddVolatileFile(file_string)) {
+		if (!cache.GetSourceList()->AddVolatileFile(file_string)) {
 			_error->Error("%s", ("Couldn't add '" + file_string + "' to the cache.").c_str());
 		}
 	}
+}
+
+inline UniquePtr<PkgCacheFile> create_cache(rust::Slice<const str> volatile_files) {
+	RUST_APT_CALL();
+	UniquePtr<PkgCacheFile> cache = new_unique<PkgCacheFile>();
+
+	add_volatile_files(*cache, volatile_files);
 
 	// Building the pkg caches can cause an error that might not
 	// Get propagated until you get a pkg which shouldn't have errors.
 	// See https://gitlab.com/volian/rust-apt/-/issues/24
 	cache->GetPkgCache();
-	handle_errors();
+	RUST_APT_HANDLE_ERRORS();
 
 	return cache;
 }
+
+/// Like `create_cache`, but trusts `pkgcache.bin` when nothing it was built from has changed.
+///
+/// Volatile files always go through apt's normal build. It already layers them, together with
+/// the dpkg status, on top of `srcpkgcache.bin` in memory without regenerating it.
+inline UniquePtr<PkgCacheFile> create_cache_fast(rust::Slice<const str> volatile_files) {
+	RUST_APT_CALL();
+	if (volatile_files.empty() && pkgcache_is_fresh()) {
+		UniquePtr<PkgCacheFile> cache = new_unique<PkgCacheFile>();
+		if (cache->open_trusted()) { return cache; }
+	}
+	return create_cache(volatile_files);
+}
+
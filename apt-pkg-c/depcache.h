@@ -9,53 +9,189 @@
 
 using ActionGroup = pkgDepCache::ActionGroup;
 
+/// Package state bits, mirrored by `StateFlags` in depcache.rs.
+namespace StateFlags {
+const u32 HasVersions = 1 << 0;
+const u32 Installed = 1 << 1;
+const u32 Upgradable = 1 << 2;
+const u32 Auto = 1 << 3;
+const u32 Garbage = 1 << 4;
+const u32 NewInstall = 1 << 5;
+const u32 Upgrade = 1 << 6;
+const u32 Delete = 1 << 7;
+const u32 Purge = 1 << 8;
+const u32 Keep = 1 << 9;
+const u32 Downgrade = 1 << 10;
+const u32 ReInstall = 1 << 11;
+const u32 NowBroken = 1 << 12;
+const u32 InstBroken = 1 << 13;
+const u32 Essential = 1 << 14;
+}  // namespace StateFlags
+
+/// The state of every package at one point, see `PkgDepCache::checkpoint`.
+struct DepCacheCheckpoint {
+	const pkgDepCache* owner;
+	/// Indexed by package ID.
+	std::vector<pkgDepCache::StateCache> states;
+};
+
 struct PkgDepCache {
 	pkgDepCache* ptr;
+	// If true, delete ptr during deconstruction
+	bool del;
+	/// Bumped by every call that can change the state of a package.
+	///
+	/// Rust keeps the state flags it has read until this changes. Anything added here, or in the
+	/// ProblemResolver, that marks, resolves, upgrades or restores packages must bump it before it
+	/// touches the DepCache, or Rust goes on returning the flags from before.
+	u64 mutable gen = 0;
+	/// The packages that `changed_packages` found, and the generation they were found at.
+	std::vector<u64> mutable changes;
+	u64 mutable changes_gen = UINT64_MAX;
+
+	/// Where the generation of the package states is kept, see `Package::state_flags` in Rust.
+	///
+	/// Rust reads the generation through this so checking a memoized state never calls across.
+	/// The PkgDepCache stays where it is for as long as it lives, and so does the pointer.
+	const u64* generation_ptr() const { RUST_APT_CALL(); return &gen; }
 
 	// Maybe we use this if we don't want pin_mut() all over the place in Rust.
 	PkgDepCache* unconst() const { return const_cast<PkgDepCache*>(this); }
 
-	UniquePtr<ActionGroup> action_group() const { return std::make_unique<ActionGroup>(*ptr); }
+	UniquePtr<ActionGroup> action_group() const {
+		RUST_APT_CALL();
+		return new_unique<ActionGroup>(*ptr);
+	}
 
-	bool is_upgradable(const PkgIterator& pkg) const { return (*ptr)[pkg].Upgradable(); }
+	bool is_upgradable(const PkgIterator& pkg) const {
+		RUST_APT_CALL();
+		return (*ptr)[pkg].Upgradable();
+	}
+
+	/// All of the StateFlags of a package from a single StateCache lookup.
+	u32 state_flags(const PkgIterator& pkg) const {
+		RUST_APT_CALL();
+		pkgDepCache::StateCache& state = (*ptr)[pkg];
+		bool installed = !pkg.CurrentVer().end();
+		u32 flags = 0;
+
+		if (!pkg.VersionList().end()) { flags |= StateFlags::HasVersions; }
+		if (installed) { flags |= StateFlags::Installed; }
+		if (installed && state.Upgradable()) { flags |= StateFlags::Upgradable; }
+		if (state.Flags & pkgCache::Flag::Auto) { flags |= StateFlags::Auto; }
+		if (state.Garbage) { flags |= StateFlags::Garbage; }
+		if (state.NewInstall()) { flags |= StateFlags::NewInstall; }
+		if (state.Upgrade()) { flags |= StateFlags::Upgrade; }
+		if (state.Delete()) { flags |= StateFlags::Delete; }
+		if (state.Purge()) { flags |= StateFlags::Purge; }
+		if (state.Keep()) { flags |= StateFlags::Keep; }
+		if (state.Downgrade()) { flags |= StateFlags::Downgrade; }
+		if (state.ReInstall()) { flags |= StateFlags::ReInstall; }
+		if (state.NowBroken()) { flags |= StateFlags::NowBroken; }
+		if (state.InstBroken()) { flags |= StateFlags::InstBroken; }
+		if (pkg->Flags & pkgCache::Flag::Essential) { flags |= StateFlags::Essential; }
+		return flags;
+	}
 
-	bool fix_broken() const { return pkgFixBroken(*ptr); }
+	/// The index of every package whose flags contain all of `require` and none of `exclude`.
+	Vec<u64> filter_packages(u32 require, u32 exclude) const {
+		RUST_APT_CALL();
+		Vec<u64> list;
+		for (pkgCache::PkgIterator it = ptr->GetCache().PkgBegin(); !it.end(); it++) {
+			u32 flags = state_flags(PkgIterator(it));
+			if ((flags & require) == require && (flags & exclude) == 0) {
+				list.push_back(it.Index());
+			}
+		}
+		return list;
+	}
+
+	/// The index of every package marked to be installed, removed, upgraded, downgraded or
+	/// reinstalled.
+	///
+	/// The package states are scanned once per generation, asking again before anything is marked
+	/// only copies the list.
+	Vec<u64> changed_packages() const {
+		RUST_APT_CALL();
+		if (changes_gen != gen) {
+			changes.clear();
+			for (pkgCache::PkgIterator it = ptr->GetCache().PkgBegin(); !it.end(); it++) {
+				const pkgDepCache::StateCache& state = (*ptr)[it];
+				if (state.NewInstall() || state.Delete() || state.Upgrade() || state.Downgrade() ||
+					state.ReInstall()) {
+					changes.push_back(it.Index());
+				}
+			}
+			changes_gen = gen;
+		}
+
+		Vec<u64> list;
+		list.reserve(changes.size());
+		for (u64 index : changes) { list.push_back(index); }
+		return list;
+	}
+
+	bool fix_broken() const {
+		RUST_APT_CALL();
+		gen++;
+		return pkgFixBroken(*ptr);
+	}
 
 	/// Is the Package auto installed? Packages marked as auto installed are usually dependencies.
 	bool is_auto_installed(const PkgIterator& pkg) const {
+		RUST_APT_CALL();
 		pkgDepCache::StateCache state = (*ptr)[pkg];
 		return state.Flags & pkgCache::Flag::Auto;
 	}
 
 	/// Is the Package able to be auto removed?
-	bool is_garbage(const PkgIterator& pkg) const { return (*ptr)[pkg].Garbage; }
+	bool is_garbage(const PkgIterator& pkg) const { RUST_APT_CALL(); return (*ptr)[pkg].Garbage; }
 
 	/// Is the Package marked for install?
-	bool marked_install(const PkgIterator& pkg) const { return (*ptr)[pkg].NewInstall(); }
+	bool marked_install(const PkgIterator& pkg) const {
+		RUST_APT_CALL();
+		return (*ptr)[pkg].NewInstall();
+	}
 
 	/// Is the Package marked for upgrade?
-	bool marked_upgrade(const PkgIterator& pkg) const { return (*ptr)[pkg].Upgrade(); }
+	bool marked_upgrade(const PkgIterator& pkg) const {
+		RUST_APT_CALL();
+		return (*ptr)[pkg].Upgrade();
+	}
 
 	/// Is the Package marked to be purged?
-	bool marked_purge(const PkgIterator& pkg) const { return (*ptr)[pkg].Purge(); }
+	bool marked_purge(const PkgIterator& pkg) const { RUST_APT_CALL(); return (*ptr)[pkg].Purge(); }
 
 	/// Is the Package marked for removal?
-	bool marked_delete(const PkgIterator& pkg) const { return (*ptr)[pkg].Delete(); }
+	bool marked_delete(const PkgIterator& pkg) const {
+		RUST_APT_CALL();
+		return (*ptr)[pkg].Delete();
+	}
 
 	/// Is the Package marked for keep?
-	bool marked_keep(const PkgIterator& pkg) const { return (*ptr)[pkg].Keep(); }
+	bool marked_keep(const PkgIterator& pkg) const { RUST_APT_CALL(); return (*ptr)[pkg].Keep(); }
 
 	/// Is the Package marked for downgrade?
-	bool marked_downgrade(const PkgIterator& pkg) const { return (*ptr)[pkg].Downgrade(); }
+	bool marked_downgrade(const PkgIterator& pkg) const {
+		RUST_APT_CALL();
+		return (*ptr)[pkg].Downgrade();
+	}
 
 	/// Is the Package marked for reinstall?
-	bool marked_reinstall(const PkgIterator& pkg) const { return (*ptr)[pkg].ReInstall(); }
+	bool marked_reinstall(const PkgIterator& pkg) const {
+		RUST_APT_CALL();
+		return (*ptr)[pkg].ReInstall();
+	}
 
 	/// Mark a package as automatically installed.
 	///
 	/// MarkAuto = true will mark the package as automatically installed and false will mark it as
 	/// manual
-	void mark_auto(const PkgIterator& pkg, bool mark_auto) const { ptr->MarkAuto(pkg, mark_auto); }
+	void mark_auto(const PkgIterator& pkg, bool mark_auto) const {
+		RUST_APT_CALL();
+		gen++;
+		ptr->MarkAuto(pkg, mark_auto);
+	}
 
 	/// Mark a package for keep.
 	///
@@ -77,7 +213,11 @@ struct PkgDepCache {
 	/// Depth:
 	///     Recursion tracker and is only used for printing Debug statements.
 	///     No one needs access to this. Additionally Depth cannot be over 3000.
-	bool mark_keep(const PkgIterator& pkg) const { return ptr->MarkKeep(pkg, false, false); }
+	bool mark_keep(const PkgIterator& pkg) const {
+		RUST_APT_CALL();
+		gen++;
+		return ptr->MarkKeep(pkg, false, false);
+	}
 
 	/// Mark a package for removal.
 	///
@@ -96,6 +236,8 @@ struct PkgDepCache {
 	///     Typically You would always use from user.
 	///     False here appears to be more of an implementation detail.
 	bool mark_delete(const PkgIterator& pkg, bool purge) const {
+		RUST_APT_CALL();
+		gen++;
 		return ptr->MarkDelete(pkg, purge);
 	}
 
@@ -111,15 +253,22 @@ struct PkgDepCache {
 	///
 	/// ForceImportantDeps = TODO: Study what this does.
 	bool mark_install(const PkgIterator& pkg, bool auto_inst, bool from_user) const {
+		RUST_APT_CALL();
+		gen++;
 		return ptr->MarkInstall(pkg, auto_inst, 0, from_user, false);
 	}
 
 	/// Set a version to be the candidate of it's package.
-	void set_candidate_version(const VerIterator& ver) const { ptr->SetCandidateVersion(ver); }
+	void set_candidate_version(const VerIterator& ver) const {
+		RUST_APT_CALL();
+		gen++;
+		ptr->SetCandidateVersion(ver);
+	}
 
 	/// Return the candidate version of the package.
 	UniquePtr<VerIterator> candidate_version(const PkgIterator& pkg) const {
-		return std::make_unique<VerIterator>(ptr->GetCandidateVersion(pkg));
+		RUST_APT_CALL();
+		return new_unique<VerIterator>(ptr->GetCandidateVersion(pkg));
 	}
 
 	/// Returns the installed version if it exists.
@@ -127,13 +276,14 @@ struct PkgDepCache {
 	///   installed.
 	/// * If an installed package is marked for removal, this will return [`None`].
 	UniquePtr<VerIterator> install_version(const PkgIterator& pkg) const {
+		RUST_APT_CALL();
 		pkgCache& cache = ptr->GetCache();
 
-		return std::make_unique<VerIterator>((*ptr)[pkg].InstVerIter(cache));
+		return new_unique<VerIterator>((*ptr)[pkg].InstVerIter(cache));
 	}
 
 	/// Returns the state of the dependency as u8
-	u8 dep_state(const DepIterator& dep) const { return (*ptr)[dep]; }
+	u8 dep_state(const DepIterator& dep) const { RUST_APT_CALL(); return (*ptr)[dep]; }
 
 	/// Checks if the dependency is important.
 	///
@@ -142,7 +292,10 @@ struct PkgDepCache {
 	///
 	/// Suggests, Recommends will return [true] if they are
 	/// configured to be installed.
-	bool is_important_dep(const DepIterator& dep) const { return ptr->IsImportantDep(dep); }
+	bool is_important_dep(const DepIterator& dep) const {
+		RUST_APT_CALL();
+		return ptr->IsImportantDep(dep);
+	}
 
 	/// Mark a package for reinstallation
 	///
@@ -150,52 +303,140 @@ struct PkgDepCache {
 	///     True = The package will be marked for reinstall
 	///     False = The package will be unmarked for reinstall
 	void mark_reinstall(const PkgIterator& pkg, bool reinstall) const {
+		RUST_APT_CALL();
+		gen++;
 		ptr->SetReInstall(pkg, reinstall);
 	}
 
 	/// Is the installed Package broken?
-	bool is_now_broken(const PkgIterator& pkg) const { return (*ptr)[pkg].NowBroken(); }
+	bool is_now_broken(const PkgIterator& pkg) const {
+		RUST_APT_CALL();
+		return (*ptr)[pkg].NowBroken();
+	}
 
 	/// Is the Package to be installed broken?
-	bool is_inst_broken(const PkgIterator& pkg) const { return (*ptr)[pkg].InstBroken(); }
+	bool is_inst_broken(const PkgIterator& pkg) const {
+		RUST_APT_CALL();
+		return (*ptr)[pkg].InstBroken();
+	}
+
+	/// Save the state of every package so it can be restored with `rollback`.
+	UniquePtr<DepCacheCheckpoint> checkpoint() const {
+		RUST_APT_CALL();
+		pkgCache& cache = ptr->GetCache();
+		UniquePtr<DepCacheCheckpoint> checkpoint = new_unique<DepCacheCheckpoint>();
+		checkpoint->owner = ptr;
+		checkpoint->states.resize(cache.Head().PackageCount);
+
+		for (pkgCache::PkgIterator pkg = cache.PkgBegin(); !pkg.end(); pkg++) {
+			checkpoint->states[pkg->ID] = (*ptr)[pkg];
+		}
+		return checkpoint;
+	}
+
+	/// Restore the packages that changed since the checkpoint, returning how many there were.
+	///
+	/// Finding them is a single compare per package; only the changed packages are marked again,
+	/// all within one action group.
+	u32 rollback(const DepCacheCheckpoint& checkpoint) const {
+		RUST_APT_CALL();
+		if (checkpoint.owner != ptr) {
+			RUST_APT_THROW("Checkpoint was taken from a different DepCache");
+		}
+		return restore(checkpoint.states);
+	}
+
+	/// Mark every package whose state differs from `states`, indexed by package ID, to match it.
+	u32 restore(const std::vector<pkgDepCache::StateCache>& states) const {
+		pkgCache& cache = ptr->GetCache();
+		pkgDepCache::ActionGroup group(*ptr);
+		u32 restored = 0;
+		gen++;
+
+		for (pkgCache::PkgIterator pkg = cache.PkgBegin(); !pkg.end(); pkg++) {
+			const pkgDepCache::StateCache& old = states[pkg->ID];
+			const pkgDepCache::StateCache& now = (*ptr)[pkg];
+
+			if (old.Mode == now.Mode && old.CandidateVer == now.CandidateVer &&
+				old.InstallVer == now.InstallVer && old.iFlags == now.iFlags &&
+				(old.Flags & pkgCache::Flag::Auto) == (now.Flags & pkgCache::Flag::Auto)) {
+				continue;
+			}
+
+			// The candidate has to be back in place before marking it for install.
+			if (old.CandidateVer != now.CandidateVer) {
+				ptr->SetCandidateVersion(pkgCache::VerIterator(cache, old.CandidateVer));
+			}
+
+			// Marks from the user get past holds and protection, both are put back below.
+			(*ptr)[pkg].MarkProtected(false);
+			switch (old.Mode) {
+				case pkgDepCache::ModeDelete:
+					ptr->MarkDelete(pkg, (old.iFlags & pkgDepCache::Purge) != 0, 0, true);
+					break;
+				case pkgDepCache::ModeInstall:
+					ptr->MarkInstall(pkg, false, 0, true, false);
+					break;
+				default:
+					ptr->MarkKeep(pkg, (old.iFlags & pkgDepCache::AutoKept) != 0, true);
+			}
+
+			ptr->SetReInstall(pkg, (old.iFlags & pkgDepCache::ReInstall) != 0);
+			ptr->MarkAuto(pkg, (old.Flags & pkgCache::Flag::Auto) != 0);
+			(*ptr)[pkg].MarkProtected((old.iFlags & pkgDepCache::Protected) != 0);
+			restored++;
+		}
+		return restored;
+	}
 
 	/// The number of packages marked for installation.
-	u32 install_count() const { return ptr->InstCount(); }
+	u32 install_count() const { RUST_APT_CALL(); return ptr->InstCount(); }
 
 	/// The number of packages marked for removal.
-	u32 delete_count() const { return ptr->DelCount(); }
+	u32 delete_count() const { RUST_APT_CALL(); return ptr->DelCount(); }
 
 	/// The number of packages marked for keep.
-	u32 keep_count() const { return ptr->KeepCount(); }
+	u32 keep_count() const { RUST_APT_CALL(); return ptr->KeepCount(); }
 
 	/// The number of packages with broken dependencies in the cache.
-	u32 broken_count() const { return ptr->BrokenCount(); }
+	u32 broken_count() const { RUST_APT_CALL(); return ptr->BrokenCount(); }
 
 	/// The size of all packages to be downloaded.
-	u64 download_size() const { return ptr->DebSize(); }
+	u64 download_size() const { RUST_APT_CALL(); return ptr->DebSize(); }
 
 	/// The amount of space required for installing/removing the packages,"
 	///
 	/// i.e. the Installed-Size of all packages marked for installation"
 	/// minus the Installed-Size of all packages for removal."
-	i64 disk_size() const { return ptr->UsrSize(); }
+	i64 disk_size() const { RUST_APT_CALL(); return ptr->UsrSize(); }
 
 	/// Perform a Full Upgrade. Remove and install new packages if necessary.
 	void upgrade(OperationProgress& callback, int upgrade_mode) const {
+		RUST_APT_CALL();
 		OpProgressWrapper op_progress(callback);
+		gen++;
 		// It is currently unclear if we should return a bool here. I think Result should be fine.
 		APT::Upgrade::Upgrade(*ptr, upgrade_mode, &op_progress);
-		handle_errors();
+		RUST_APT_HANDLE_ERRORS();
 	}
 
 	/// Clear any marked changes in the DepCache.
 	void init(OperationProgress& callback) const {
+		RUST_APT_CALL();
 		OpProgressWrapper op_progress(callback);
+		gen++;
 
 		ptr->Init(&op_progress);
 		// pkgApplyStatus(*cache->GetDepCache());
-		handle_errors();
+		RUST_APT_HANDLE_ERRORS();
 	}
 
-	PkgDepCache(pkgDepCache* DepCache) : ptr(DepCache){};
+	PkgDepCache(pkgDepCache* DepCache) : ptr(DepCache), del(false){};
+	PkgDepCache(pkgDepCache* DepCache, bool del) : ptr(DepCache), del(del){};
+	// Copies would delete ptr twice when del is set.
+	PkgDepCache(const PkgDepCache&) = delete;
+	PkgDepCache& operator=(const PkgDepCache&) = delete;
+	~PkgDepCache() {
+		if (del) { delete ptr; }
+	};
 };
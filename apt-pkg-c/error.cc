@@ -4,6 +4,7 @@
 #include "types.h"
 
 Vec<AptError> get_all() noexcept {
+	RUST_APT_CALL();
 	Vec<AptError> list;
 
 	while (!_error->empty()) {
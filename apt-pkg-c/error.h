@@ -6,8 +6,8 @@
 #include "types.h"
 
 /// Handle the situation where a string is null and return a result to rust
-inline bool pending_error() { return _error->PendingError(); }
+inline bool pending_error() { RUST_APT_CALL(); return _error->PendingError(); }
 
-inline bool empty() { return _error->empty(); }
+inline bool empty() { RUST_APT_CALL(); return _error->empty(); }
 
 Vec<AptError> get_all() noexcept;
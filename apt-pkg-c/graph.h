@@ -0,0 +1,90 @@
+#pragma once
+#include <apt-pkg/depcache.h>
+#include <apt-pkg/pkgcache.h>
+#include <vector>
+#include "rust/cxx.h"
+
+// Defines the shared DepGraphData struct
+#include "rust-apt/src/graph.rs"
+
+#include "cache.h"
+#include "types.h"
+
+/// Edge flags, mirrored by `EdgeFlags` in graph.rs.
+///
+/// The low 4 bits of an edge are its dependency type.
+namespace EdgeFlags {
+const u8 Installed = 1 << 4;
+const u8 Candidate = 1 << 5;
+}  // namespace EdgeFlags
+
+struct GraphEdge {
+	u32 from;
+	u32 to;
+	u8 info;
+};
+
+/// Sort the edges by `from`, or by `to` if reversed, into compressed rows.
+inline void fill_rows(
+	const std::vector<GraphEdge>& edges,
+	size_t count,
+	bool reverse,
+	Vec<u32>& offsets,
+	Vec<u32>& nodes,
+	Vec<u8>& info
+) {
+	std::vector<u32> start(count + 1, 0);
+	for (const GraphEdge& edge : edges) { start[(reverse ? edge.to : edge.from) + 1]++; }
+	for (size_t i = 0; i < count; i++) { start[i + 1] += start[i]; }
+
+	std::vector<u32> row_nodes(edges.size());
+	std::vector<u8> row_info(edges.size());
+	std::vector<u32> next(start.begin(), start.end() - 1);
+	for (const GraphEdge& edge : edges) {
+		u32 slot = next[reverse ? edge.to : edge.from]++;
+		row_nodes[slot] = reverse ? edge.from : edge.to;
+		row_info[slot] = edge.info;
+	}
+
+	offsets.reserve(start.size());
+	for (u32 offset : start) { offsets.push_back(offset); }
+	nodes.reserve(row_nodes.size());
+	for (u32 node : row_nodes) { nodes.push_back(node); }
+	info.reserve(row_info.size());
+	for (u8 edge_info : row_info) { info.push_back(edge_info); }
+}
+
+/// Build the forward and reverse dependency graph of every version, indexed by package ID.
+inline DepGraphData build_dep_graph(const PkgCacheFile& cache_file) {
+	RUST_APT_CALL();
+	pkgCache* cache = cache_file.unconst()->GetPkgCache();
+	pkgDepCache* depcache = cache_file.unconst()->GetDepCache();
+	size_t count = cache->Head().PackageCount;
+
+	std::vector<u64> pkg_index(count, 0);
+	std::vector<GraphEdge> edges;
+	edges.reserve(cache->Head().DependsCount);
+
+	for (pkgCache::PkgIterator pkg = cache->PkgBegin(); !pkg.end(); pkg++) {
+		pkg_index[pkg->ID] = pkg.Index();
+		pkgCache::VerIterator current = pkg.CurrentVer();
+		pkgCache::VerIterator candidate = (*depcache)[pkg].CandidateVerIter(*depcache);
+
+		for (pkgCache::VerIterator ver = pkg.VersionList(); !ver.end(); ver++) {
+			u8 flags = 0;
+			if (ver == current) { flags |= EdgeFlags::Installed; }
+			if (ver == candidate) { flags |= EdgeFlags::Candidate; }
+
+			for (pkgCache::DepIterator dep = ver.DependsList(); !dep.end(); dep++) {
+				edges.push_back(GraphEdge{pkg->ID, dep.TargetPkg()->ID, u8(dep->Type | flags)});
+			}
+		}
+	}
+
+	DepGraphData graph;
+	graph.pkg_index.reserve(count);
+	for (u64 index : pkg_index) { graph.pkg_index.push_back(index); }
+	fill_rows(edges, count, false, graph.fwd_offsets, graph.fwd_nodes, graph.fwd_info);
+	fill_rows(edges, count, true, graph.rev_offsets, graph.rev_nodes, graph.rev_info);
+	return graph;
+}
@@ -8,17 +8,24 @@
 
 struct VerIterator;
 struct PkgIterator;
+struct TargetIterator;
 
 struct DepIterator : public pkgCache::DepIterator {
-	void raw_next() { (*this)++; }
+	void raw_next() { RUST_APT_CALL(); (*this)++; }
 
-	UniquePtr<DepIterator> unique() const { return std::make_unique<DepIterator>(*this); }
+	UniquePtr<DepIterator> unique() const {
+		RUST_APT_CALL();
+		return new_unique<DepIterator>(*this);
+	}
 
-	u8 dep_type() const { return (*this)->Type; }
-	str comp_type() const { return handle_str(this->CompType()); }
-	str target_ver() const { return handle_str(this->TargetVer()); }
+	u8 dep_type() const { RUST_APT_CALL(); return (*this)->Type; }
+	str comp_type() const { RUST_APT_CALL(); return RUST_APT_HANDLE_STR(this->CompType()); }
+	str comp_type_or_empty() const { RUST_APT_CALL(); return str_or_empty(this->CompType()); }
+	str target_ver() const { RUST_APT_CALL(); return RUST_APT_HANDLE_STR(this->TargetVer()); }
+	str target_ver_or_empty() const { RUST_APT_CALL(); return str_or_empty(this->TargetVer()); }
 
 	inline bool or_dep() const {
+		RUST_APT_CALL();
 		return ((*this)->CompareOp & pkgCache::Dep::Or) == pkgCache::Dep::Or;
 	}
 
@@ -26,159 +33,235 @@ struct DepIterator : public pkgCache::DepIterator {
 	UniquePtr<PkgIterator> target_pkg() const;
 	UniquePtr<VerIterator> parent_ver() const;
 	UniquePtr<std::vector<VerIterator>> all_targets() const;
+	UniquePtr<TargetIterator> targets() const;
 
 	DepIterator(const pkgCache::DepIterator& base) : pkgCache::DepIterator(base){};
 };
 
 struct PrvIterator : public pkgCache::PrvIterator {
-	void raw_next() { (*this)++; }
+	void raw_next() { RUST_APT_CALL(); (*this)++; }
 
-	str name() const { return this->Name(); }
-	str version_str() const { return handle_str(this->ProvideVersion()); }
+	str name() const { RUST_APT_CALL(); return this->Name(); }
+	str version_str() const { RUST_APT_CALL(); return RUST_APT_HANDLE_STR(this->ProvideVersion()); }
+	str version_str_or_empty() const {
+		RUST_APT_CALL();
+		return str_or_empty(this->ProvideVersion());
+	}
 
 	UniquePtr<PkgIterator> target_pkg() const;
 	UniquePtr<VerIterator> target_ver() const;
 
-	UniquePtr<PrvIterator> unique() const { return std::make_unique<PrvIterator>(*this); }
+	UniquePtr<PrvIterator> unique() const {
+		RUST_APT_CALL();
+		return new_unique<PrvIterator>(*this);
+	}
 
 	PrvIterator(const pkgCache::PrvIterator& base) : pkgCache::PrvIterator(base){};
 };
 
 struct PkgFileIterator : public pkgCache::PkgFileIterator {
-	void raw_next() { (*this)++; }
-
-	str filename() const { return handle_str(this->FileName()); }
-	str archive() const { return handle_str(this->Archive()); }
-	str origin() const { return handle_str(this->Origin()); }
-	str codename() const { return handle_str(this->Codename()); }
-	str label() const { return handle_str(this->Label()); }
-	str site() const { return handle_str(this->Site()); }
-	str component() const { return handle_str(this->Component()); }
-	str arch() const { return handle_str(this->Architecture()); }
-	str index_type() const { return handle_str(this->IndexType()); }
-
-	bool is_downloadable() const { return !this->Flagged(pkgCache::Flag::NotSource); }
+	void raw_next() { RUST_APT_CALL(); (*this)++; }
+
+	str filename() const { RUST_APT_CALL(); return RUST_APT_HANDLE_STR(this->FileName()); }
+	str filename_or_empty() const { RUST_APT_CALL(); return str_or_empty(this->FileName()); }
+	str archive() const { RUST_APT_CALL(); return RUST_APT_HANDLE_STR(this->Archive()); }
+	str archive_or_empty() const { RUST_APT_CALL(); return str_or_empty(this->Archive()); }
+	str origin() const { RUST_APT_CALL(); return RUST_APT_HANDLE_STR(this->Origin()); }
+	str origin_or_empty() const { RUST_APT_CALL(); return str_or_empty(this->Origin()); }
+	str codename() const { RUST_APT_CALL(); return RUST_APT_HANDLE_STR(this->Codename()); }
+	str codename_or_empty() const { RUST_APT_CALL(); return str_or_empty(this->Codename()); }
+	str label() const { RUST_APT_CALL(); return RUST_APT_HANDLE_STR(this->Label()); }
+	str label_or_empty() const { RUST_APT_CALL(); return str_or_empty(this->Label()); }
+	str site() const { RUST_APT_CALL(); return RUST_APT_HANDLE_STR(this->Site()); }
+	str site_or_empty() const { RUST_APT_CALL(); return str_or_empty(this->Site()); }
+	str component() const { RUST_APT_CALL(); return RUST_APT_HANDLE_STR(this->Component()); }
+	str component_or_empty() const { RUST_APT_CALL(); return str_or_empty(this->Component()); }
+	str arch() const { RUST_APT_CALL(); return RUST_APT_HANDLE_STR(this->Architecture()); }
+	str arch_or_empty() const { RUST_APT_CALL(); return str_or_empty(this->Architecture()); }
+	str index_type() const { RUST_APT_CALL(); return RUST_APT_HANDLE_STR(this->IndexType()); }
+	str index_type_or_empty() const { RUST_APT_CALL(); return str_or_empty(this->IndexType()); }
+
+	bool is_downloadable() const {
+		RUST_APT_CALL();
+		return !this->Flagged(pkgCache::Flag::NotSource);
+	}
 
-	UniquePtr<PkgFileIterator> unique() const { return std::make_unique<PkgFileIterator>(*this); }
+	UniquePtr<PkgFileIterator> unique() const {
+		RUST_APT_CALL();
+		return new_unique<PkgFileIterator>(*this);
+	}
 
 	PkgFileIterator(const pkgCache::PkgFileIterator& base) : pkgCache::PkgFileIterator(base){};
 };
 
 struct VerFileIterator : public pkgCache::VerFileIterator {
-	void raw_next() { (*this)++; }
+	void raw_next() { RUST_APT_CALL(); (*this)++; }
 
-	UniquePtr<VerFileIterator> unique() const { return std::make_unique<VerFileIterator>(*this); }
+	UniquePtr<VerFileIterator> unique() const {
+		RUST_APT_CALL();
+		return new_unique<VerFileIterator>(*this);
+	}
 
 	UniquePtr<PkgFileIterator> package_file() const {
-		return std::make_unique<PkgFileIterator>(this->File());
+		RUST_APT_CALL();
+		return new_unique<PkgFileIterator>(this->File());
 	};
 
+	/// The index of the package file, without building an iterator for it.
+	u64 file_index() const { RUST_APT_CALL(); return (*this)->File; }
+
+	/// Where the record starts within the package file.
+	u64 offset() const { RUST_APT_CALL(); return (*this)->Offset; }
+
 	VerFileIterator(const pkgCache::VerFileIterator& base) : pkgCache::VerFileIterator(base){};
 };
 
 struct DescIterator : public pkgCache::DescIterator {
-	void raw_next() { (*this)++; }
+	void raw_next() { RUST_APT_CALL(); (*this)++; }
 
-	UniquePtr<DescIterator> unique() const { return std::make_unique<DescIterator>(*this); }
+	UniquePtr<DescIterator> unique() const {
+		RUST_APT_CALL();
+		return new_unique<DescIterator>(*this);
+	}
 
 	DescIterator(const pkgCache::DescIterator& base) : pkgCache::DescIterator(base){};
 };
 
 struct VerIterator : public pkgCache::VerIterator {
-	void raw_next() { (*this)++; }
-
-	str version() const { return this->VerStr(); }
-	str arch() const { return this->Arch(); }
-	str section() const { return handle_str(this->Section()); }
-	str priority_str() const { return handle_str(this->PriorityType()); }
-	str source_name() const { return this->SourcePkgName(); }
-	str source_version() const { return this->SourceVerStr(); }
-	u64 size() const { return (*this)->Size; }
-	u64 installed_size() const { return (*this)->InstalledSize; }
+	void raw_next() { RUST_APT_CALL(); (*this)++; }
+
+	str version() const { RUST_APT_CALL(); return this->VerStr(); }
+	str arch() const { RUST_APT_CALL(); return this->Arch(); }
+	str section() const { RUST_APT_CALL(); return RUST_APT_HANDLE_STR(this->Section()); }
+	str section_or_empty() const { RUST_APT_CALL(); return str_or_empty(this->Section()); }
+	str priority_str() const { RUST_APT_CALL(); return RUST_APT_HANDLE_STR(this->PriorityType()); }
+	str priority_str_or_empty() const {
+		RUST_APT_CALL();
+		return str_or_empty(this->PriorityType());
+	}
+	str source_name() const { RUST_APT_CALL(); return this->SourcePkgName(); }
+	str source_version() const { RUST_APT_CALL(); return this->SourceVerStr(); }
+	u64 size() const { RUST_APT_CALL(); return (*this)->Size; }
+	u64 installed_size() const { RUST_APT_CALL(); return (*this)->InstalledSize; }
 	// TODO: Move this into rust?
-	bool is_installed() const { return this->ParentPkg().CurrentVer() == *this; }
+	bool is_installed() const { RUST_APT_CALL(); return this->ParentPkg().CurrentVer() == *this; }
 
 	UniquePtr<PkgIterator> parent_pkg() const;
 
 	// This is for backend records lookups.
 	UniquePtr<DescIterator> translated_desc() const {
-		return std::make_unique<DescIterator>(this->TranslatedDescription());
+		RUST_APT_CALL();
+		return new_unique<DescIterator>(this->TranslatedDescription());
 	}
 
 	// This is for backend records lookups.
 	// You go through here to get the package files.
 	UniquePtr<VerFileIterator> version_files() const {
-		return std::make_unique<VerFileIterator>(this->FileList());
+		RUST_APT_CALL();
+		return new_unique<VerFileIterator>(this->FileList());
 	}
 
 	UniquePtr<DepIterator> depends() const {
-		return std::make_unique<DepIterator>(this->DependsList());
+		RUST_APT_CALL();
+		return new_unique<DepIterator>(this->DependsList());
 	}
 
 	UniquePtr<PrvIterator> provides() const {
-		return std::make_unique<PrvIterator>(this->ProvidesList());
+		RUST_APT_CALL();
+		return new_unique<PrvIterator>(this->ProvidesList());
 	}
 
-	UniquePtr<VerIterator> unique() const { return std::make_unique<VerIterator>(*this); }
+	UniquePtr<VerIterator> unique() const {
+		RUST_APT_CALL();
+		return new_unique<VerIterator>(*this);
+	}
 
 	VerIterator(const pkgCache::VerIterator& base) : pkgCache::VerIterator(base){};
 };
 
 struct PkgIterator : public pkgCache::PkgIterator {
-	void raw_next() { (*this)++; }
+	void raw_next() { RUST_APT_CALL(); (*this)++; }
+
+	/// Move to the package at the offset given by `Index`, without a new allocation.
+	void seek(u64 index) {
+		RUST_APT_CALL();
+		pkgCache* cache = this->Cache();
+		pkgCache::PkgIterator& base = *this;
+		base = pkgCache::PkgIterator(*cache, cache->PkgP + index);
+	}
 
-	str name() const { return this->Name(); }
-	str arch() const { return this->Arch(); }
-	String fullname(bool Pretty) const { return this->FullName(Pretty); }
-	u8 current_state() const { return (*this)->CurrentState; }
-	u8 inst_state() const { return (*this)->InstState; }
-	u8 selected_state() const { return (*this)->SelectedState; }
+	str name() const { RUST_APT_CALL(); return this->Name(); }
+	str arch() const { RUST_APT_CALL(); return this->Arch(); }
+	u32 id() const { RUST_APT_CALL(); return (*this)->ID; }
+	String fullname(bool Pretty) const {
+		RUST_APT_CALL();
+		return new_string(this->FullName(Pretty));
+	}
+	u8 current_state() const { RUST_APT_CALL(); return (*this)->CurrentState; }
+	u8 inst_state() const { RUST_APT_CALL(); return (*this)->InstState; }
+	u8 selected_state() const { RUST_APT_CALL(); return (*this)->SelectedState; }
 
 	/// True if the package is essential.
-	bool is_essential() const { return ((*this)->Flags & pkgCache::Flag::Essential) != 0; }
+	bool is_essential() const {
+		RUST_APT_CALL();
+		return ((*this)->Flags & pkgCache::Flag::Essential) != 0;
+	}
 
 	UniquePtr<VerIterator> current_version() const {
-		return std::make_unique<VerIterator>(this->CurrentVer());
+		RUST_APT_CALL();
+		return new_unique<VerIterator>(this->CurrentVer());
 	}
 
 	UniquePtr<VerIterator> versions() const {
-		return std::make_unique<VerIterator>(this->VersionList());
+		RUST_APT_CALL();
+		return new_unique<VerIterator>(this->VersionList());
 	}
 
 	UniquePtr<PrvIterator> provides() const {
-		return std::make_unique<PrvIterator>(this->ProvidesList());
+		RUST_APT_CALL();
+		return new_unique<PrvIterator>(this->ProvidesList());
 	}
 
 	UniquePtr<DepIterator> rdepends() const {
-		return std::make_unique<DepIterator>(this->RevDependsList());
+		RUST_APT_CALL();
+		return new_unique<DepIterator>(this->RevDependsList());
 	}
 
-	UniquePtr<PkgIterator> unique() const { return std::make_unique<PkgIterator>(*this); }
+	UniquePtr<PkgIterator> unique() const {
+		RUST_APT_CALL();
+		return new_unique<PkgIterator>(*this);
+	}
 
 	PkgIterator(const pkgCache::PkgIterator& base) : pkgCache::PkgIterator(base){};
 };
 
 inline UniquePtr<PkgIterator> PrvIterator::target_pkg() const {
-	return std::make_unique<PkgIterator>(this->OwnerPkg());
+	RUST_APT_CALL();
+	return new_unique<PkgIterator>(this->OwnerPkg());
 }
 
 inline UniquePtr<VerIterator> PrvIterator::target_ver() const {
-	return std::make_unique<VerIterator>(this->OwnerVer());
+	RUST_APT_CALL();
+	return new_unique<VerIterator>(this->OwnerVer());
 }
 
 inline UniquePtr<PkgIterator> DepIterator::parent_pkg() const {
-	return std::make_unique<PkgIterator>(this->ParentPkg());
+	RUST_APT_CALL();
+	return new_unique<PkgIterator>(this->ParentPkg());
 }
 
 inline UniquePtr<VerIterator> DepIterator::parent_ver() const {
-	return std::make_unique<VerIterator>(this->ParentVer());
+	RUST_APT_CALL();
+	return new_unique<VerIterator>(this->ParentVer());
 }
 
 inline UniquePtr<PkgIterator> DepIterator::target_pkg() const {
-	return std::make_unique<PkgIterator>(this->TargetPkg());
+	RUST_APT_CALL();
+	return new_unique<PkgIterator>(this->TargetPkg());
 }
 
 inline UniquePtr<std::vector<VerIterator>> DepIterator::all_targets() const {
+	RUST_APT_CALL();
 	// pkgPrioSortList for sorting by priority?
 	//
 	// The version list returned is not a VerIterator.
@@ -191,9 +274,65 @@ inline UniquePtr<std::vector<VerIterator>> DepIterator::all_targets() const {
 		list.push_back(VerIterator(pkgCache::VerIterator(*this->Cache(), *I)));
 	}
 
-	return std::make_unique<std::vector<VerIterator>>(list);
+	return new_unique<std::vector<VerIterator>>(std::move(list));
+}
+
+/// Walks the versions that satisfy a dependency without building a list first.
+///
+/// This visits the same versions as `AllTargets`, in the same order: the versions of the target
+/// package and then the versions providing it.
+struct TargetIterator {
+	pkgCache::DepIterator dep;
+	pkgCache::VerIterator ver;
+	pkgCache::PrvIterator prv;
+
+	/// Skip ahead to the next version, or provide, that satisfies the dependency.
+	void settle() {
+		for (; !ver.end(); ver++) {
+			if (!dep.IsIgnorable(ver.ParentPkg()) && dep.IsSatisfied(ver)) { return; }
+		}
+		for (; !prv.end(); prv++) {
+			if (!dep.IsIgnorable(prv) && dep.IsSatisfied(prv)) { return; }
+		}
+	}
+
+	void raw_next() {
+		RUST_APT_CALL();
+		if (!ver.end()) {
+			ver++;
+		} else if (!prv.end()) {
+			prv++;
+		}
+		settle();
+	}
+
+	bool end() const { RUST_APT_CALL(); return ver.end() && prv.end(); }
+
+	/// The version the iterator is on.
+	UniquePtr<VerIterator> version() const {
+		RUST_APT_CALL();
+		return new_unique<VerIterator>(ver.end() ? prv.OwnerVer() : ver);
+	}
+
+	UniquePtr<TargetIterator> unique() const {
+		RUST_APT_CALL();
+		return new_unique<TargetIterator>(*this);
+	}
+
+	TargetIterator(const pkgCache::DepIterator& base)
+		: dep(base),
+		  ver(base.TargetPkg().VersionList()),
+		  prv(base.TargetPkg().ProvidesList()) {
+		settle();
+	}
+};
+
+inline UniquePtr<TargetIterator> DepIterator::targets() const {
+	RUST_APT_CALL();
+	return new_unique<TargetIterator>(*this);
 }
 
 inline UniquePtr<PkgIterator> VerIterator::parent_pkg() const {
-	return std::make_unique<PkgIterator>(this->ParentPkg());
+	RUST_APT_CALL();
+	return new_unique<PkgIterator>(this->ParentPkg());
 }
@@ -19,6 +19,7 @@ struct PackageManager {
 		const PkgRecords& records,
 		AcqTextStatus& archive_progress
 	) const {
+		RUST_APT_CALL();
 		pkgAcquire acquire(&archive_progress);
 
 		// We probably need to let the user set their own pkgSourcePkgCacheFileList,
@@ -28,8 +29,8 @@ struct PackageManager {
 		if (!pkgmanager->GetArchives(
 				&acquire, cache.unconst()->GetSourceList(), &records.records
 			)) {
-			handle_errors();
-			throw std::runtime_error(
+			RUST_APT_HANDLE_ERRORS();
+			RUST_APT_THROW(
 				"Internal Issue with rust-apt in pkgmanager_get_archives."
 				" Please report this as an issue."
 			);
@@ -42,19 +43,20 @@ struct PackageManager {
 			// Failed will always have an error for us to handle
 			// It's unsure if Cancelled would even require a bool
 			// I believe this may be a Keyboard Interrupt situation
-			handle_errors();
+			RUST_APT_HANDLE_ERRORS();
 		}
 	}
 
 	void do_install(InstallProgress& callback) const {
+		RUST_APT_CALL();
 		PackageManagerWrapper install_progress(callback);
 		pkgPackageManager::OrderResult res = pkgmanager->DoInstall(&install_progress);
 
 		if (res == pkgPackageManager::OrderResult::Completed) {
 			return;
 		} else if (res == pkgPackageManager::OrderResult::Failed) {
-			handle_errors();
-			throw std::runtime_error(
+			RUST_APT_HANDLE_ERRORS();
+			RUST_APT_THROW(
 				"Internal Issue with rust-apt in pkgmanager_do_install."
 				" DoInstall has failed but there was no error from apt."
 				" Please report this as an issue."
@@ -62,8 +64,8 @@ struct PackageManager {
 		} else if (res == pkgPackageManager::OrderResult::Incomplete) {
 			// It's not clear that there would be any apt errors here,
 			// But we'll try anyway. This is believed to be only for media swapping
-			handle_errors();
-			throw std::runtime_error(
+			RUST_APT_HANDLE_ERRORS();
+			RUST_APT_THROW(
 				"Internal Issue with rust-apt in pkgmanager_do_install."
 				" DoInstall returned Incomplete, media swaps are unsupported."
 				" Please request media swapping as a feature."
@@ -72,8 +74,8 @@ struct PackageManager {
 			// If for whatever reason we manage to make it here (We shouldn't)
 			// Attempt to handle any apt errors
 			// And then fallback with a message to report with the result code.
-			handle_errors();
-			throw std::runtime_error(
+			RUST_APT_HANDLE_ERRORS();
+			RUST_APT_THROW(
 				"Internal Issue with rust-apt in pkgmanager_do_install."
 				" Please report this as an issue. OrderResult: " +
 				res
@@ -86,27 +88,30 @@ struct PackageManager {
 
 struct ProblemResolver {
 	pkgProblemResolver mutable resolver;
+	const PkgDepCache& depcache;
 
 	/// Mark a package as protected, i.e. don't let its installation/removal state change when
 	/// modifying packages during resolution.
-	void protect(const PkgIterator& pkg) const { resolver.Protect(pkg); }
+	void protect(const PkgIterator& pkg) const { RUST_APT_CALL(); resolver.Protect(pkg); }
 
 	/// Try to resolve dependency problems by marking packages for installation and removal.
 	void resolve(bool fix_broken, OperationProgress& callback) const {
+		RUST_APT_CALL();
 		OpProgressWrapper op_progress(callback);
+		depcache.gen++;
 		resolver.Resolve(fix_broken, &op_progress);
-		handle_errors();
+		RUST_APT_HANDLE_ERRORS();
 	}
 
-	ProblemResolver(pkgDepCache* depcache) : resolver(depcache){};
+	ProblemResolver(const PkgDepCache& depcache) : resolver(depcache.ptr), depcache(depcache){};
 };
 
 /// Create the problem resolver.
 UniquePtr<ProblemResolver> create_problem_resolver(const PkgDepCache& cache) {
-	return std::make_unique<ProblemResolver>(cache.ptr);
+	return new_unique<ProblemResolver>(cache);
 }
 
 UniquePtr<PackageManager> create_pkgmanager(const PkgDepCache& cache) {
 	// Package Manager needs the DepCache initialized or else invalid memory reference.
-	return std::make_unique<PackageManager>(cache.ptr);
+	return new_unique<PackageManager>(cache.ptr);
 }
@@ -5,27 +5,80 @@
 #include <apt-pkg/pkgrecords.h>
 #include <apt-pkg/pkgsystem.h>
 #include <apt-pkg/sourcelist.h>
+#include <apt-pkg/tagfile.h>
 #include <memory>
 #include "rust/cxx.h"
 
+// Defines the shared FieldSpan struct
+#include "rust-apt/src/records.rs"
+
 #include "package.h"
 #include "types.h"
 
 struct IndexFile {
 	pkgIndexFile* ptr;
 
-	String archive_uri(str filename) const { return ptr->ArchiveURI(std::string(filename)); }
-	bool is_trusted() const { return ptr->IsTrusted(); }
+	String archive_uri(str filename) const {
+		RUST_APT_CALL();
+		return new_string(ptr->ArchiveURI(std::string(filename)));
+	}
+	bool is_trusted() const { RUST_APT_CALL(); return ptr->IsTrusted(); }
 
 	IndexFile(pkgIndexFile* file) : ptr(file){};
 };
 
 struct Parser {
 	pkgRecords::Parser& ptr;
+	/// The current record, only scanned once a borrowed field is requested.
+	pkgTagSection mutable section;
+	bool mutable scanned = false;
+	mutable const char* rec_start = nullptr;
+	mutable const char* rec_stop = nullptr;
+
+	/// The section of the current record, scanned once per record.
+	const pkgTagSection& tags() const {
+		if (!scanned) {
+			ptr.GetRec(rec_start, rec_stop);
+			if (!section.Scan(rec_start, rec_stop - rec_start)) {
+				RUST_APT_THROW("Unable to parse the record");
+			}
+			scanned = true;
+		}
+		return section;
+	}
+
+	/// Borrow the whole current record.
+	str record() const {
+		RUST_APT_CALL();
+		tags();
+		return str(rec_start, rec_stop - rec_start);
+	}
+
+	/// Find each field within `record()` from a single scan of the record.
+	Vec<FieldSpan> find_fields(Slice<const str> fields) const {
+		RUST_APT_CALL();
+		const pkgTagSection& tag_section = tags();
+		Vec<FieldSpan> spans;
+		spans.reserve(fields.size());
 
-	String short_desc() const { return handle_string(ptr.ShortDesc()); }
-	String long_desc() const { return handle_string(ptr.LongDesc()); }
-	String filename() const { return ptr.FileName(); }
+		for (auto field : fields) {
+			const char* start;
+			const char* end;
+			FieldSpan span{false, 0, 0};
+			if (tag_section.Find(APT::StringView(field.data(), field.length()), start, end) &&
+				start != end) {
+				span = FieldSpan{true, u32(start - rec_start), u32(end - rec_start)};
+			}
+			spans.push_back(span);
+		}
+		return spans;
+	}
+
+	String short_desc() const { RUST_APT_CALL(); return RUST_APT_HANDLE_STRING(ptr.ShortDesc()); }
+	String long_desc() const { RUST_APT_CALL(); return RUST_APT_HANDLE_STRING(ptr.LongDesc()); }
+	String short_desc_or_empty() const { RUST_APT_CALL(); return new_string(ptr.ShortDesc()); }
+	String long_desc_or_empty() const { RUST_APT_CALL(); return new_string(ptr.LongDesc()); }
+	String filename() const { RUST_APT_CALL(); return new_string(ptr.FileName()); }
 
 	// TODO: Maybe look into this more if there is time. I was trying to save an allocation
 	// ptr.RecordField(field.begin())
@@ -34,15 +87,59 @@ struct Parser {
 	// This will not work with just "Maintainer" string literal
 
 	/// Return the Source package version String.
-	String get_field(String field) const { return handle_string(ptr.RecordField(field.c_str())); }
+	String get_field(String field) const {
+		RUST_APT_CALL();
+		return RUST_APT_HANDLE_STRING(ptr.RecordField(field.c_str()));
+	}
+
+	/// `get_field`, but an empty String when the field doesn't exist.
+	String get_field_or_empty(String field) const {
+		RUST_APT_CALL();
+		return new_string(ptr.RecordField(field.c_str()));
+	}
+
+	/// Borrow the value of a field straight from the record.
+	///
+	/// The view stays valid until the records are moved to another file.
+	str get_field_ref(str field) const {
+		RUST_APT_CALL();
+		const char* start;
+		const char* end;
+		if (!tags().Find(APT::StringView(field.data(), field.length()), start, end) ||
+			start == end) {
+			RUST_APT_THROW("Field Not Found");
+		}
+		return str(start, end - start);
+	}
+
+	/// `get_field_ref`, but an empty str when the field doesn't exist.
+	str get_field_ref_or_empty(str field) const {
+		RUST_APT_CALL();
+		const char* start;
+		const char* end;
+		if (!tags().Find(APT::StringView(field.data(), field.length()), start, end)) {
+			return str();
+		}
+		return str(start, end - start);
+	}
 
 	// TODO: Lets Go Ahead and Bind HashStrings while we're here ffs
 	/// Find the hash of a Version. Returns Result if there is no hash.
 	String hash_find(String hash_type) const {
+		RUST_APT_CALL();
+		auto hashes = ptr.Hashes();
+		auto hash = hashes.find(hash_type.c_str());
+		if (hash == NULL) { RUST_APT_THROW("Hash Not Found"); }
+		return RUST_APT_HANDLE_STRING(hash->HashValue());
+	}
+
+	/// `hash_find`, but an empty String when there is no hash.
+	String hash_find_or_empty(String hash_type) const {
+		RUST_APT_CALL();
 		auto hashes = ptr.Hashes();
 		auto hash = hashes.find(hash_type.c_str());
-		if (hash == NULL) { throw std::runtime_error("Hash Not Found"); }
-		return handle_string(hash->HashValue());
+		if (hash == NULL) { return String(); }
+		return new_string(hash->HashValue());
 	}
 
 	Parser(pkgRecords::Parser& parser) : ptr(parser){};
@@ -52,12 +149,14 @@ struct PkgRecords {
 	pkgRecords mutable records;
 
 	UniquePtr<Parser> ver_lookup(const VerFileIterator& file) const {
-		return std::make_unique<Parser>(records.Lookup(file));
+		RUST_APT_CALL();
+		return new_unique<Parser>(records.Lookup(file));
 	}
 
 	/// Moves the Records into the correct place.
 	UniquePtr<Parser> desc_lookup(const DescIterator& desc) const {
-		return std::make_unique<Parser>(records.Lookup(desc.FileList()));
+		RUST_APT_CALL();
+		return new_unique<Parser>(records.Lookup(desc.FileList()));
 	}
 
 	PkgRecords(pkgCacheFile* cache) : records(*cache->GetPkgCache()){};
@@ -0,0 +1,36 @@
+#include "rust-apt/apt-pkg-c/stats.h"
+
+#include "types.h"
+
+#ifdef RUST_APT_INSTRUMENT
+/// The head of the list of every counter that has been reached.
+static std::atomic<StatCounter*> counters{nullptr};
+
+StatCounter::StatCounter(StatKind kind, const char* name) : kind(kind), name(name) {
+	next = counters.load(std::memory_order_relaxed);
+	while (!counters.compare_exchange_weak(next, this, std::memory_order_release)) {}
+}
+
+Vec<StatEntry> stats_snapshot() noexcept {
+	Vec<StatEntry> list;
+
+	for (StatCounter* c = counters.load(std::memory_order_acquire); c; c = c->next) {
+		list.push_back(StatEntry{
+			static_cast<u8>(c->kind),
+			c->name,
+			c->count.load(std::memory_order_relaxed),
+		});
+	}
+	return list;
+}
+
+void stats_reset() noexcept {
+	for (StatCounter* c = counters.load(std::memory_order_acquire); c; c = c->next) {
+		c->count.store(0, std::memory_order_relaxed);
+	}
+}
+#else
+Vec<StatEntry> stats_snapshot() noexcept { return {}; }
+
+void stats_reset() noexcept {}
+#endif
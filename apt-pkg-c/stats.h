@@ -0,0 +1,11 @@
+#pragma once
+#include "rust-apt/src/stats.rs"
+#include "rust/cxx.h"
+
+#include "types.h"
+
+/// Returns every counter that has been reached, empty without the `instrument` feature.
+Vec<StatEntry> stats_snapshot() noexcept;
+
+/// Set every counter back to zero.
+void stats_reset() noexcept;
@@ -0,0 +1,75 @@
+#pragma once
+#include <apt-pkg/fileutl.h>
+#include <apt-pkg/tagfile.h>
+#include <memory>
+#include <string>
+#include "rust/cxx.h"
+
+#include "types.h"
+#include "util.h"
+
+struct TagSection {
+	pkgTagSection section;
+
+	/// Look up a field through apt's index of the section, an empty str when it doesn't exist.
+	str find_or_empty(str field) const {
+		RUST_APT_CALL();
+		const char* start;
+		const char* end;
+		if (!section.Find(APT::StringView(field.data(), field.length()), start, end)) {
+			return str();
+		}
+		return str(start, end - start);
+	}
+
+	bool exists(str field) const {
+		RUST_APT_CALL();
+		return section.Exists(APT::StringView(field.data(), field.length()));
+	}
+
+	/// The number of fields in the section.
+	u32 count() const { RUST_APT_CALL(); return section.Count(); }
+
+	/// Borrow the whole text of the section.
+	str text() const {
+		RUST_APT_CALL();
+		const char* start;
+		const char* stop;
+		section.GetSection(start, stop);
+		return str(start, stop - start);
+	}
+};
+
+struct TagFile {
+	FileFd fd;
+	std::unique_ptr<pkgTagFile> tags;
+	TagSection current;
+
+	/// Move to the next section, returns false at the end of the file.
+	///
+	/// The previous section is no longer valid after this.
+	bool step() {
+		RUST_APT_CALL();
+		bool stepped = tags->Step(current.section);
+		RUST_APT_HANDLE_ERRORS();
+		return stepped;
+	}
+
+	/// The section the file was last stepped to.
+	const TagSection& section() const { RUST_APT_CALL(); return current; }
+
+	/// The offset in the uncompressed file of the current section.
+	u64 offset() { RUST_APT_CALL(); return tags->Offset(); }
+};
+
+/// Open a TagFile, decompressing it based on its extension.
+inline UniquePtr<TagFile> open_tagfile(str path) {
+	RUST_APT_CALL();
+	auto file = new_unique<TagFile>();
+	file->fd.Open(std::string(path), FileFd::ReadOnly, FileFd::Extension);
+	RUST_APT_HANDLE_ERRORS();
+
+	file->tags = new_unique<pkgTagFile>(&file->fd);
+	RUST_APT_HANDLE_ERRORS();
+	return file;
+}
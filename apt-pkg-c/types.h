@@ -1,8 +1,15 @@
 #pragma once
 #include <apt-pkg/indexfile.h>
 #include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
 #include "rust/cxx.h"
 
+#ifdef RUST_APT_INSTRUMENT
+#include <atomic>
+#endif
+
 using namespace rust;
 
 template <typename T>
@@ -12,3 +19,85 @@ using UniquePtr = std::unique_ptr<T>;
 struct ItemDesc;
 struct PkgAcquire;
 struct AcqWorker;
+
+struct StatCounter;
+
+/// What a counter counts, mirrored by `StatKind` in stats.rs.
+enum class StatKind : u8 {
+	Call = 0,
+	Alloc = 1,
+	Exception = 2,
+};
+
+#ifdef RUST_APT_INSTRUMENT
+/// A counter for one place in the bridge, built with the `instrument` feature.
+///
+/// Each counter is a static that links itself into the list in stats.cc the first time it is
+/// reached, after that counting is a single relaxed add.
+struct StatCounter {
+	StatKind kind;
+	const char* name;
+	std::atomic<u64> count{0};
+	StatCounter* next = nullptr;
+
+	StatCounter(StatKind kind, const char* name);
+	void add() { count.fetch_add(1, std::memory_order_relaxed); }
+};
+
+#define RUST_APT_COUNT(kind, name)                       \
+	do {                                                 \
+		static StatCounter rust_apt_counter(kind, name); \
+		rust_apt_counter.add();                          \
+	} while (0)
+
+/// The counter of `kind` for this call site, named after the enclosing function.
+///
+/// This is an expression, so it can be handed to a helper that counts on behalf of its caller.
+/// The name is passed in because `__PRETTY_FUNCTION__` inside the lambda would name the lambda.
+#define RUST_APT_COUNTER(kind)                                    \
+	[](const char* rust_apt_name) {                               \
+		static StatCounter rust_apt_counter(kind, rust_apt_name); \
+		return &rust_apt_counter;                                 \
+	}(__PRETTY_FUNCTION__)
+#else
+#define RUST_APT_COUNT(kind, name) ((void)0)
+#define RUST_APT_COUNTER(kind) static_cast<StatCounter*>(nullptr)
+#endif
+
+/// Add one to a counter from `RUST_APT_COUNTER`.
+inline void rust_apt_count(StatCounter* counter) {
+#ifdef RUST_APT_INSTRUMENT
+	counter->add();
+#else
+	(void)counter;
+#endif
+}
+
+/// Count a call into the bridge under the name of the enclosing function.
+#define RUST_APT_CALL() RUST_APT_COUNT(StatKind::Call, __PRETTY_FUNCTION__)
+
+/// Throw the exception cxx turns into an `Err`, counted under the enclosing function.
+#define RUST_APT_THROW(msg)                                       \
+	do {                                                          \
+		RUST_APT_COUNT(StatKind::Exception, __PRETTY_FUNCTION__); \
+		throw std::runtime_error(msg);                            \
+	} while (0)
+
+/// The name of `T`, as `__PRETTY_FUNCTION__` prints it.
+template <typename T>
+inline const char* type_name() {
+	return __PRETTY_FUNCTION__;
+}
+
+/// `std::make_unique`, counted as an allocation of `T`.
+template <typename T, typename... Args>
+inline UniquePtr<T> new_unique(Args&&... args) {
+	RUST_APT_COUNT(StatKind::Alloc, type_name<T>());
+	return std::make_unique<T>(std::forward<Args>(args)...);
+}
+
+/// A String for Rust, counted as an allocation of `String`.
+inline String new_string(const std::string& string) {
+	RUST_APT_COUNT(StatKind::Alloc, "String");
+	return string;
+}
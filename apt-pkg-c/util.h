@@ -1,6 +1,8 @@
 #pragma once
 #include <apt-pkg/algorithms.h>
 #include <apt-pkg/cachefile.h>
+#include <apt-pkg/fileutl.h>
+#include <apt-pkg/hashes.h>
 #include <apt-pkg/install-progress.h>
 #include <apt-pkg/pkgsystem.h>
 #include <apt-pkg/version.h>
@@ -13,53 +15,95 @@
 /// Internal Helper Functions.
 /// Do not expose these on the Rust side - only for use on the C++ side.
 ///
+/// `handle_errors`, `handle_str` and `handle_string` are called through the
+/// `RUST_APT_HANDLE_ERRORS`, `RUST_APT_HANDLE_STR` and `RUST_APT_HANDLE_STRING` macros after them,
+/// which pass in the exception counter of the calling function. A throw is counted under the
+/// caller, not the helper.
+///
 /// Handle any apt errors and return result to rust.
-inline void handle_errors() {
+inline void handle_errors(StatCounter* exceptions) {
 	// !_error->empty() will cause a Result when there are only warnings
 	// Instead use PendingErr()
 	// Actual handling of the errors is done in rust
-	if (_error->PendingError()) { throw std::runtime_error("convert to AptErrors"); }
+	if (_error->PendingError()) {
+		rust_apt_count(exceptions);
+		throw std::runtime_error("convert to AptErrors");
+	}
 }
 
 /// Handle the situation where a string is null and return a result to rust
-inline const char* handle_str(const char* str) {
-	if (!str || !strcmp(str, "")) { throw std::runtime_error("&str doesn't exist"); }
+inline const char* handle_str(const char* str, StatCounter* exceptions) {
+	if (!str || !strcmp(str, "")) {
+		rust_apt_count(exceptions);
+		throw std::runtime_error("&str doesn't exist");
+	}
 	return str;
 }
 
 /// Check if a string exists and return a Result to rust
-inline String handle_string(std::string string) {
-	if (string.empty()) { throw std::runtime_error("String doesn't exist"); }
-	return string;
+inline String handle_string(const std::string& string, StatCounter* exceptions) {
+	if (string.empty()) {
+		rust_apt_count(exceptions);
+		throw std::runtime_error("String doesn't exist");
+	}
+	return new_string(string);
 }
 
+#define RUST_APT_HANDLE_ERRORS() handle_errors(RUST_APT_COUNTER(StatKind::Exception))
+#define RUST_APT_HANDLE_STR(value) handle_str(value, RUST_APT_COUNTER(StatKind::Exception))
+#define RUST_APT_HANDLE_STRING(value) handle_string(value, RUST_APT_COUNTER(StatKind::Exception))
+
+/// Return an empty str instead of throwing when a string is null.
+///
+/// The `_or_empty` accessors use this, the Rust side turns empty into None without unwinding.
+inline const char* str_or_empty(const char* str) { return str ? str : ""; }
+
 //////////////////////////////////
 /// End Internal Helper Functions.
 //////////////////////////////////
 
 /// Compare two package version strings.
 inline i32 cmp_versions(str ver1, str ver2) {
+	RUST_APT_CALL();
 	if (!_system) { pkgInitSystem(*_config, _system); }
 
-	const char* end1 = ver1.begin() + strlen(ver1.begin());
-	const char* end2 = ver2.begin() + strlen(ver2.begin());
-
-	return _system->VS->DoCmpVersion(ver1.begin(), end1, ver2.begin(), end2);
+	// Rust strings are not null terminated, strlen would run past the end. apt still reads the
+	// character after each part, so copy them to get the terminator.
+	std::string a(ver1);
+	std::string b(ver2);
+	return _system->VS->DoCmpVersion(
+		a.c_str(), a.c_str() + a.size(), b.c_str(), b.c_str() + b.size()
+	);
 }
 
 /// Return an APT-styled progress bar (`[####  ]`).
 inline String get_apt_progress_string(f32 percent, u32 output_width) {
-	return APT::Progress::PackageManagerFancy::GetTextProgressStr(percent, output_width);
+	RUST_APT_CALL();
+	return new_string(
+		APT::Progress::PackageManagerFancy::GetTextProgressStr(percent, output_width)
+	);
+}
+
+/// The SHA256 of the file at `path`, hashed the same way apt checks what it downloads.
+inline String file_sha256(str path) {
+	RUST_APT_CALL();
+	FileFd fd(std::string(path), FileFd::ReadOnly);
+	Hashes hashes(Hashes::SHA256SUM);
+	if (fd.IsOpen()) { hashes.AddFD(fd); }
+	RUST_APT_HANDLE_ERRORS();
+	return new_string(hashes.GetHashString(Hashes::SHA256SUM).HashValue());
 }
 
 /// Lock the APT lockfile.
 inline void apt_lock() {
+	RUST_APT_CALL();
 	_system->Lock();
-	handle_errors();
+	RUST_APT_HANDLE_ERRORS();
 }
 
 /// Unlock the APT lockfile.
 inline void apt_unlock() {
+	RUST_APT_CALL();
 	// This can only throw an error that says "Not Locked"
 	// By setting NoErrors true, this will return false instead
 	// This is largely irrelevant and will be a void function
@@ -68,15 +112,17 @@ inline void apt_unlock() {
 
 /// Lock the Dpkg lockfile.
 inline void apt_lock_inner() {
+	RUST_APT_CALL();
 	_system->LockInner();
-	handle_errors();
+	RUST_APT_HANDLE_ERRORS();
 }
 
 /// Unlock the Dpkg lockfile.
 inline void apt_unlock_inner() {
+	RUST_APT_CALL();
 	// UnlockInner can not throw an error and always returns true.
 	_system->UnLockInner();
 }
 
 /// Check if the lockfile is locked.
-inline bool apt_is_locked() { return _system->IsLocked(); }
+inline bool apt_is_locked() { RUST_APT_CALL(); return _system->IsLocked(); }
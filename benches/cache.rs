@@ -0,0 +1,330 @@
+//! Benchmarks of the hot paths over a synthetic repository.
+//!
+//! A `Packages` file is generated for each size and opened as a local file,
+//! so the numbers don't depend on what the machine has configured. The same
+//! size always generates the same file.
+//!
+//! Run with `just bench`. `RUST_APT_BENCH_SIZES` is a comma separated list of
+//! package counts and `RUST_APT_BENCH_ITERS` the number of timed runs.
+//!
+//! Allocations are counted by the global allocator below, so they only
+//! include the Rust side. Built with `--features instrument` the calls into
+//! the C++ side are counted as well.
+use std::alloc::{GlobalAlloc, Layout, System};
+use std::fmt::Write as _;
+use std::path::PathBuf;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::time::{Duration, Instant};
+use std::{env, fs, hint, process};
+
+use rust_apt::cache::{Cache, PackageSort};
+use rust_apt::records::RecordField;
+use rust_apt::stats::{stats, Stats};
+
+const DEFAULT_SIZES: &str = "10000,60000,150000";
+const DEFAULT_ITERS: usize = 5;
+
+/// How many packages the per package benchmarks look at.
+const SAMPLE: usize = 1000;
+
+/// Part of the directory the repository is generated in. Change it whenever
+/// `generate` writes something different, so files of an older version are
+/// never reused.
+const GENERATOR_VERSION: u32 = 1;
+
+static ALLOCS: AtomicU64 = AtomicU64::new(0);
+static BYTES: AtomicU64 = AtomicU64::new(0);
+
+struct CountingAlloc;
+
+unsafe impl GlobalAlloc for CountingAlloc {
+	unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+		ALLOCS.fetch_add(1, Ordering::Relaxed);
+		BYTES.fetch_add(layout.size() as u64, Ordering::Relaxed);
+		System.alloc(layout)
+	}
+
+	unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) { System.dealloc(ptr, layout) }
+
+	unsafe fn realloc(&self, ptr: *mut u8, layout: Layout, new_size: usize) -> *mut u8 {
+		ALLOCS.fetch_add(1, Ordering::Relaxed);
+		BYTES.fetch_add(new_size as u64, Ordering::Relaxed);
+		System.realloc(ptr, layout, new_size)
+	}
+}
+
+#[global_allocator]
+static GLOBAL: CountingAlloc = CountingAlloc;
+
+/// A small LCG, so the repository is the same on every run.
+struct Rng(u64);
+
+impl Rng {
+	fn next(&mut self) -> u64 {
+		self.0 = self
+			.0
+			.wrapping_mul(6364136223846793005)
+			.wrapping_add(1442695040888963407);
+		self.0 >> 33
+	}
+
+	fn below(&mut self, n: usize) -> usize { (self.next() % n.max(1) as u64) as usize }
+}
+
+/// Write a `Packages` file of `size` packages, in the style of the control
+/// files in `tests/files/cache`.
+///
+/// Every package only depends on packages before it, so marking the last
+/// one pulls in a long chain without conflicts.
+///
+/// The file is written under another name and renamed into place, so a run
+/// that was stopped halfway never leaves a file that is reused.
+fn generate(size: usize) -> PathBuf {
+	let dir = env::temp_dir().join(format!("rust-apt-bench-v{GENERATOR_VERSION}-{size}"));
+	let path = dir.join("Packages");
+	if path.exists() {
+		return path;
+	}
+
+	let mut rng = Rng(size as u64);
+	let mut out = String::with_capacity(size * 700);
+
+	for i in 0..size {
+		let version = format!("{}.{}.{}-{}", 1 + i % 7, i % 13, i % 5, 1 + i % 3);
+		writeln!(out, "Package: bench-pkg-{i}").unwrap();
+		writeln!(out, "Version: {version}").unwrap();
+		writeln!(out, "Architecture: all").unwrap();
+		let maintainer = i % 97;
+		writeln!(
+			out,
+			"Maintainer: Bench Maintainer {maintainer} <bench{maintainer}@example.com>"
+		)
+		.unwrap();
+		writeln!(out, "Installed-Size: {}", 10 + rng.below(5000)).unwrap();
+
+		if i > 0 {
+			let depends: Vec<String> = (0..rng.below(4))
+				.map(|n| {
+					let dep = rng.below(i);
+					match n {
+						0 => format!("bench-pkg-{dep} (>= 1.0)"),
+						1 if dep >= 10 => {
+							format!("bench-pkg-{dep} | bench-virtual-{}", rng.below(dep / 10))
+						},
+						_ => format!("bench-pkg-{dep}"),
+					}
+				})
+				.collect();
+			if !depends.is_empty() {
+				writeln!(out, "Depends: {}", depends.join(", ")).unwrap();
+			}
+		}
+		if i % 10 == 0 {
+			writeln!(out, "Provides: bench-virtual-{}", i / 10).unwrap();
+		}
+
+		writeln!(out, "Priority: optional").unwrap();
+		writeln!(
+			out,
+			"Section: {}",
+			["admin", "libs", "utils", "devel"][i % 4]
+		)
+		.unwrap();
+		if i % 2 == 0 {
+			writeln!(out, "Homepage: https://example.com/bench-pkg-{i}").unwrap();
+		}
+		writeln!(
+			out,
+			"Filename: pool/main/b/bench-pkg-{i}/bench-pkg-{i}_{version}_all.deb"
+		)
+		.unwrap();
+		writeln!(out, "Size: {}", 1000 + rng.below(1_000_000)).unwrap();
+		let sha256: String = (0..8).map(|_| format!("{:08x}", rng.next())).collect();
+		writeln!(out, "SHA256: {sha256}").unwrap();
+		writeln!(out, "Description: Synthetic package number {i}").unwrap();
+		writeln!(
+			out,
+			" This package would never exist in a normal APT repository."
+		)
+		.unwrap();
+		writeln!(
+			out,
+			" It only exists to give the benchmarks something to parse."
+		)
+		.unwrap();
+		out.push('\n');
+	}
+
+	fs::create_dir_all(&dir).unwrap();
+	let tmp = dir.join(format!("Packages.{}.tmp", process::id()));
+	fs::write(&tmp, out).unwrap();
+	fs::rename(&tmp, &path).unwrap();
+	path
+}
+
+/// The timing and allocations of a benchmark, per run.
+struct Report {
+	name: &'static str,
+	size: usize,
+	ops: u64,
+	time: Duration,
+	allocs: u64,
+	bytes: u64,
+	calls: u64,
+}
+
+impl Report {
+	fn print(&self) {
+		let ops = self.ops.max(1);
+		print!(
+			"{:<14} {:>7} {:>12.3?} {:>12.0} ops/s {:>10.2} allocs/op {:>10.1} B/op",
+			self.name,
+			self.size,
+			self.time,
+			ops as f64 / self.time.as_secs_f64(),
+			self.allocs as f64 / ops as f64,
+			self.bytes as f64 / ops as f64,
+		);
+		if Stats::enabled() {
+			print!(" {:>10.2} calls/op", self.calls as f64 / ops as f64);
+		}
+		println!();
+	}
+}
+
+/// The calls into the C++ side so far, 0 without the `instrument` feature.
+fn ffi_calls() -> u64 {
+	if Stats::enabled() {
+		stats().total_calls()
+	} else {
+		0
+	}
+}
+
+/// Run `f` once to warm up and then `iters` times, keeping the median run.
+///
+/// `f` returns how many operations it did, which is what throughput and
+/// allocations are divided by.
+fn bench<F>(name: &'static str, size: usize, iters: usize, mut f: F) -> Report
+where
+	F: FnMut() -> u64,
+{
+	hint::black_box(f());
+
+	let mut runs: Vec<(Duration, u64, u64, u64, u64)> = (0..iters.max(1))
+		.map(|_| {
+			// Taking the snapshot allocates, so do it outside of the counted section.
+			let calls = ffi_calls();
+			let (allocs, bytes) = (
+				ALLOCS.load(Ordering::Relaxed),
+				BYTES.load(Ordering::Relaxed),
+			);
+			let start = Instant::now();
+			let ops = hint::black_box(f());
+			let time = start.elapsed();
+			let (allocs, bytes) = (
+				ALLOCS.load(Ordering::Relaxed) - allocs,
+				BYTES.load(Ordering::Relaxed) - bytes,
+			);
+			(time, ops, allocs, bytes, ffi_calls() - calls)
+		})
+		.collect();
+
+	runs.sort_unstable_by_key(|run| run.0);
+	let (time, ops, allocs, bytes, calls) = runs[runs.len() / 2];
+	Report {
+		name,
+		size,
+		ops,
+		time,
+		allocs,
+		bytes,
+		calls,
+	}
+}
+
+fn run(size: usize, iters: usize, wanted: &dyn Fn(&str) -> bool) -> Vec<Report> {
+	let path = generate(size);
+	let files = [path.to_str().unwrap()];
+	let names: Vec<String> = (0..size)
+		.step_by((size / SAMPLE).max(1))
+		.map(|i| format!("bench-pkg-{i}"))
+		.collect();
+
+	let mut reports = Vec::new();
+
+	if wanted("open") {
+		// Opening is slow enough that a few runs are plenty.
+		reports.push(bench("open", size, iters.min(3), || {
+			Cache::new(&files).unwrap();
+			1
+		}));
+	}
+
+	let cache = Cache::new(&files).unwrap();
+
+	if wanted("packages") {
+		reports.push(bench("packages", size, iters, || {
+			cache.packages(&PackageSort::default()).count() as u64
+		}));
+	}
+
+	if wanted("rdepends") {
+		reports.push(bench("rdepends", size, iters, || {
+			for name in &names {
+				let pkg = cache.get(name).unwrap();
+				hint::black_box(pkg.rdepends().values().map(Vec::len).sum::<usize>());
+			}
+			names.len() as u64
+		}));
+	}
+
+	if wanted("records") {
+		reports.push(bench("records", size, iters, || {
+			for name in &names {
+				let ver = cache.get(name).unwrap().candidate().unwrap();
+				hint::black_box(ver.get_record(RecordField::Maintainer));
+				hint::black_box(ver.get_record(RecordField::Homepage));
+			}
+			names.len() as u64
+		}));
+	}
+
+	if wanted("resolve") {
+		// Each run marks the whole dependency chain of the last package.
+		let top = format!("bench-pkg-{}", size - 1);
+		reports.push(bench("resolve", size, iters, || {
+			cache.get(&top).unwrap().mark_install(true, true);
+			cache.resolve(true).unwrap();
+			let changes = cache.get_changes(false).count() as u64;
+			cache.depcache().clear_marked().unwrap();
+			changes
+		}));
+	}
+
+	reports
+}
+
+fn main() {
+	// `cargo bench` passes `--bench`, anything else is a name filter.
+	let filter: Vec<String> = env::args()
+		.skip(1)
+		.filter(|a| !a.starts_with("--"))
+		.collect();
+	let sizes = env::var("RUST_APT_BENCH_SIZES").unwrap_or_else(|_| DEFAULT_SIZES.to_string());
+	let iters = env::var("RUST_APT_BENCH_ITERS")
+		.ok()
+		.and_then(|iters| iters.parse().ok())
+		.unwrap_or(DEFAULT_ITERS);
+
+	println!(
+		"{:<14} {:>7} {:>12} {:>18} {:>20} {:>15}",
+		"benchmark", "size", "time", "throughput", "allocations", "bytes"
+	);
+	let wanted = |name: &str| filter.is_empty() || filter.iter().any(|f| name.contains(f.as_str()));
+	for size in sizes.split(',').filter_map(|size| size.trim().parse().ok()) {
+		for report in run(size, iters, &wanted) {
+			report.print();
+		}
+	}
+}
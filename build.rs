@@ -9,6 +9,9 @@ fn main() {
 		"src/pkgmanager.rs",
 		"src/error.rs",
 		"src/acquire.rs",
+		"src/graph.rs",
+		"src/tagfile.rs",
+		"src/stats.rs",
 		"src/iterators/package.rs",
 		"src/iterators/version.rs",
 		"src/iterators/dependency.rs",
@@ -16,12 +19,14 @@ fn main() {
 		"src/iterators/files.rs",
 	];
 
-	let mut cc_files = vec!["apt-pkg-c/error.cc"];
+	let mut cc_files = vec!["apt-pkg-c/error.cc", "apt-pkg-c/stats.cc"];
 
-	cxx_build::bridges(&source_files)
-		.files(&cc_files)
-		.flag_if_supported("-std=c++14")
-		.compile("rust-apt");
+	let mut build = cxx_build::bridges(&source_files);
+	build.files(&cc_files).flag_if_supported("-std=c++14");
+	if std::env::var_os("CARGO_FEATURE_INSTRUMENT").is_some() {
+		build.define("RUST_APT_INSTRUMENT", None);
+	}
+	build.compile("rust-apt");
 
 	println!("cargo:rustc-link-lib=apt-pkg");
 	for file in source_files {
@@ -40,6 +45,9 @@ fn main() {
 		"apt-pkg-c/error.h",
 		"apt-pkg-c/types.h",
 		"apt-pkg-c/acquire.h",
+		"apt-pkg-c/graph.h",
+		"apt-pkg-c/tagfile.h",
+		"apt-pkg-c/stats.h",
 	]);
 
 	for file in cc_files {
@@ -134,6 +134,13 @@ pub(crate) mod raw {
 		/// CxxVector of active workers
 		pub fn workers(self: &PkgAcquire) -> UniquePtr<CxxVector<AcqWorker>>;
 
+		/// The number of workers, without copying them like
+		/// [`PkgAcquire::workers`].
+		pub fn worker_count(self: &PkgAcquire) -> u32;
+
+		/// The number of workers with an item in progress.
+		pub fn busy_workers(self: &PkgAcquire) -> u32;
+
 		/// Get the ItemDesc that contain the source list URIs
 		///
 		/// # Safety
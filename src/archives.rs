@@ -0,0 +1,208 @@
+//! A store of downloaded archives that can be shared between caches.
+//!
+//! Every archive is kept under its SHA256, so chroots and containers on the
+//! same host can point at one store. Before downloading, archives the store
+//! already has are linked into `Dir::Cache::archives`, where apt finds them
+//! and skips the download. After downloading, the new archives are linked
+//! back into the store. Archives are hashed on the way in and on the way
+//! out, and any that don't match their SHA256 are left behind.
+//!
+//! ```
+//! use rust_apt::archives::ArchiveStore;
+//! use rust_apt::new_cache;
+//! use rust_apt::progress::AcquireProgress;
+//!
+//! let cache = new_cache!().unwrap();
+//! let store = ArchiveStore::new(std::env::temp_dir().join("rust-apt-archives")).unwrap();
+//!
+//! cache.get("neovim").unwrap().mark_install(true, true);
+//! cache.resolve(true).unwrap();
+//!
+//! // This needs root
+//! // store.get_archives(&cache, &mut AcquireProgress::apt()).unwrap();
+//! ```
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::{fs, io, process};
+
+use crate::config::Config;
+use crate::error::AptErrors;
+use crate::progress::AcquireProgress;
+use crate::raw::file_sha256;
+use crate::{Cache, Version};
+
+/// A directory of archives named by their SHA256.
+pub struct ArchiveStore {
+	root: PathBuf,
+}
+
+impl ArchiveStore {
+	/// Use `root` as the store, creating it if it doesn't exist.
+	pub fn new<P: AsRef<Path>>(root: P) -> Result<ArchiveStore, AptErrors> {
+		let root = root.as_ref().join("sha256");
+		fs::create_dir_all(&root)?;
+		Ok(ArchiveStore { root })
+	}
+
+	/// Where the archive with `sha256` is kept.
+	pub fn path(&self, sha256: &str) -> PathBuf { self.root.join(sha256.to_lowercase()) }
+
+	/// Returns [`true`] if the store has the archive with `sha256`.
+	pub fn contains(&self, sha256: &str) -> bool { self.path(sha256).is_file() }
+
+	/// Add the file at `src` to the store as the archive with `sha256`.
+	///
+	/// Returns [`false`] if the store already has it, or if `src` doesn't
+	/// hash to `sha256` and was left out.
+	pub fn insert(&self, sha256: &str, src: &Path) -> Result<bool, AptErrors> {
+		let dest = self.path(sha256);
+		if dest.exists() || !src.is_file() || !hash_matches(src, sha256) {
+			return Ok(false);
+		}
+		link_or_copy(src, &dest)?;
+		Ok(true)
+	}
+
+	/// Link the archive with `sha256` out of the store to `dest`.
+	///
+	/// An archive in the store that no longer hashes to `sha256` is removed
+	/// from it. Returns [`false`] if nothing was linked.
+	pub fn link(&self, sha256: &str, dest: &Path) -> Result<bool, AptErrors> {
+		let src = self.path(sha256);
+		if dest.exists() || !src.is_file() {
+			return Ok(false);
+		}
+		if !hash_matches(&src, sha256) {
+			fs::remove_file(&src)?;
+			return Ok(false);
+		}
+		link_or_copy(&src, dest)?;
+		Ok(true)
+	}
+
+	/// Link every archive that `cache` is about to download and the store
+	/// already has into the archives directory.
+	///
+	/// Returns how many were linked.
+	pub fn link_into(&self, cache: &Cache) -> Result<usize, AptErrors> {
+		let mut linked = 0;
+		for (sha256, dest) in archives(cache) {
+			if self.link(&sha256, &dest)? {
+				linked += 1;
+			}
+		}
+		Ok(linked)
+	}
+
+	/// Add the archives of every change in `cache` that are in the archives
+	/// directory to the store.
+	///
+	/// Each one is hashed first, an archive that doesn't match the SHA256
+	/// of its version is not added.
+	///
+	/// Returns how many were added.
+	pub fn store_from(&self, cache: &Cache) -> Result<usize, AptErrors> {
+		let mut stored = 0;
+		for (sha256, src) in archives(cache) {
+			if self.insert(&sha256, &src)? {
+				stored += 1;
+			}
+		}
+		Ok(stored)
+	}
+
+	/// Link in what the store has, download the rest with
+	/// [`Cache::get_archives`], and add what was downloaded to the store.
+	pub fn get_archives(
+		&self,
+		cache: &Cache,
+		progress: &mut AcquireProgress,
+	) -> Result<(), AptErrors> {
+		self.link_into(cache)?;
+		cache.get_archives(progress)?;
+		self.store_from(cache)?;
+		Ok(())
+	}
+}
+
+/// The file name apt gives the archive of `ver` in `Dir::Cache::archives`.
+///
+/// This is `name_version_arch.deb`, quoted the same way as `pkgAcqArchive`.
+pub fn archive_filename(ver: &Version) -> Option<String> {
+	let file = ver.version_files().next()?.lookup().filename();
+	let ext = file.rsplit_once('.').map_or(file.as_str(), |(_, ext)| ext);
+	Some(format!(
+		"{}_{}_{}.{ext}",
+		quote(ver.parent().name(), "_:"),
+		quote(ver.version(), "_:"),
+		quote(ver.arch(), "_:."),
+	))
+}
+
+/// The SHA256 and archive path of every version that `get_archives` would
+/// download.
+fn archives(cache: &Cache) -> Vec<(String, PathBuf)> {
+	let dir = PathBuf::from(Config::new().dir("Dir::Cache::archives", "/var/cache/apt/archives/"));
+
+	cache
+		.get_changes(false)
+		.filter(|pkg| !pkg.marked_delete())
+		.filter_map(|pkg| {
+			let ver = pkg.install_version()?;
+			Some((ver.sha256()?, dir.join(archive_filename(&ver)?)))
+		})
+		.collect()
+}
+
+/// Returns [`true`] if the file at `path` hashes to `sha256`.
+///
+/// A file that can't be read doesn't match.
+fn hash_matches(path: &Path, sha256: &str) -> bool {
+	let Some(path) = path.to_str() else {
+		return false;
+	};
+	match file_sha256(path) {
+		Ok(hash) => hash.eq_ignore_ascii_case(sha256),
+		Err(err) => {
+			// Take the errors off apt's stack so the next call doesn't see them.
+			drop(AptErrors::from(err));
+			false
+		},
+	}
+}
+
+/// Escape `%`, anything in `bad`, spaces, and anything outside of printable
+/// ascii as `%xx`, like apt's `QuoteString`.
+fn quote(string: &str, bad: &str) -> String {
+	let mut quoted = String::with_capacity(string.len());
+	for c in string.bytes() {
+		if c == b'%' || bad.as_bytes().contains(&c) || c <= 0x20 || c >= 0x7F {
+			quoted.push_str(&format!("%{c:02x}"));
+		} else {
+			quoted.push(c as char);
+		}
+	}
+	quoted
+}
+
+/// Hard link `src` to `dest`, copying if they are on different file
+/// systems.
+///
+/// The link is made under a temporary name and renamed into place, so no
+/// one ever sees a partial archive. The name is unique to the process and
+/// call, so two stores writing the same archive never share it.
+fn link_or_copy(src: &Path, dest: &Path) -> io::Result<()> {
+	static COUNT: AtomicUsize = AtomicUsize::new(0);
+
+	let name = dest.file_name().unwrap_or_default().to_string_lossy();
+	let count = COUNT.fetch_add(1, Ordering::Relaxed);
+	let tmp = dest.with_file_name(format!(".{name}.{}.{count}.partial", process::id()));
+
+	let result = fs::hard_link(src, &tmp)
+		.or_else(|_| fs::copy(src, &tmp).map(drop))
+		.and_then(|_| fs::rename(&tmp, dest));
+	if result.is_err() {
+		let _ = fs::remove_file(&tmp);
+	}
+	result
+}
@@ -2,21 +2,29 @@
 
 use std::cell::OnceCell;
 use std::fs;
+use std::marker::PhantomData;
+use std::ops::Deref;
 use std::path::Path;
+use std::pin::Pin;
 
 use cxx::{Exception, UniquePtr};
+#[doc(inline)]
+pub use raw::PackageColumns;
 
-use crate::config::{init_config_system, Config};
-use crate::depcache::DepCache;
+use crate::config::init_config_system;
+use crate::depcache::{DepCache, DepCacheFork};
 use crate::error::AptErrors;
-use crate::progress::{AcquireProgress, InstallProgress, OperationProgress};
+use crate::graph::DepGraph;
+use crate::parallel::ParPackages;
+use crate::progress::{AcquireProgress, InstallProgress, OpStats, OperationProgress};
 use crate::raw::{
-	create_cache, create_pkgmanager, create_problem_resolver, IntoRawIter, IterPkgIterator,
-	PackageManager, PkgCacheFile, PkgIterator, ProblemResolver,
+	create_cache, create_cache_fast, create_pkgmanager, create_problem_resolver, CursorPkgIterator,
+	IntoRawIter, IterPkgIterator, PackageManager, PkgCacheFile, PkgDepCache, PkgIterator,
+	ProblemResolver, VerIterator, VersionIndex,
 };
-use crate::records::PackageRecords;
-use crate::util::{apt_lock, apt_unlock, apt_unlock_inner};
-use crate::Package;
+use crate::records::{PackageRecords, RecordReader};
+use crate::util::{apt_is_locked, apt_lock, apt_unlock, apt_unlock_inner};
+use crate::{Package, StateFlags, Version};
 
 /// Selection of Upgrade type
 #[repr(i32)]
@@ -135,6 +143,36 @@ impl PackageSort {
 		self.auto_removable = Sort::Reverse;
 		self
 	}
+
+	/// The [`StateFlags`] a package must have and must not have to be
+	/// included.
+	fn flags(&self) -> (u32, u32) {
+		let mut require = 0;
+		let mut exclude = 0;
+
+		// Virtual packages work the other way around,
+		// they are excluded unless asked for.
+		match self.virtual_pkgs {
+			Sort::Disable => require |= StateFlags::HasVersions,
+			Sort::Enable => {},
+			Sort::Reverse => exclude |= StateFlags::HasVersions,
+		}
+
+		for (sort, flag) in [
+			(&self.upgradable, StateFlags::Upgradable),
+			(&self.installed, StateFlags::Installed),
+			(&self.auto_installed, StateFlags::Auto),
+			(&self.auto_removable, StateFlags::Garbage),
+		] {
+			match sort {
+				Sort::Disable => {},
+				Sort::Enable => require |= flag,
+				Sort::Reverse => exclude |= flag,
+			}
+		}
+
+		(require, exclude)
+	}
 }
 
 /// The main struct for accessing any and all `apt` data.
@@ -142,8 +180,11 @@ pub struct Cache {
 	pub(crate) ptr: UniquePtr<PkgCacheFile>,
 	depcache: OnceCell<DepCache>,
 	records: OnceCell<PackageRecords>,
+	dep_graph: OnceCell<DepGraph>,
 	pkgmanager: OnceCell<UniquePtr<PackageManager>>,
 	problem_resolver: OnceCell<UniquePtr<ProblemResolver>>,
+	version_index: OnceCell<UniquePtr<VersionIndex>>,
+	volatile_files: Vec<String>,
 	local_debs: Vec<String>,
 }
 
@@ -164,23 +205,52 @@ impl Cache {
 	/// be found or are invalid.
 	///
 	/// Note that if you run [`Cache::commit`] or [`Cache::update`],
-	/// You will be required to make a new cache to perform any further changes
+	/// You will be required to make a new cache to perform any further changes.
+	/// Long running processes can use [`Cache::commit_in_place`] and
+	/// [`Cache::update_in_place`] instead, or call [`Cache::refresh`].
 	pub fn new<T: AsRef<str>>(local_files: &[T]) -> Result<Cache, AptErrors> {
 		let volatile_files: Vec<_> = local_files.iter().map(|d| d.as_ref()).collect();
 
 		init_config_system();
-		Ok(Cache {
-			ptr: create_cache(&volatile_files)?,
+		let ptr = create_cache(&volatile_files)?;
+		Ok(Cache::with_ptr(ptr, volatile_files))
+	}
+
+	/// Open the cache like [`Cache::new`], but skip apt's validation of
+	/// `pkgcache.bin` when it is newer than everything it is built from.
+	///
+	/// Instead of checking every index file, only the modification times of
+	/// the dpkg status file, the lists directory, the sources and
+	/// `srcpkgcache.bin` are compared against the cache. This makes opening
+	/// much cheaper for short lived processes.
+	///
+	/// With `local_files` the cache is always built the normal way, apt
+	/// then layers them and the dpkg status on top of `srcpkgcache.bin`.
+	/// The same happens if the existing cache can't be used as is.
+	pub fn new_fast<T: AsRef<str>>(local_files: &[T]) -> Result<Cache, AptErrors> {
+		let volatile_files: Vec<_> = local_files.iter().map(|d| d.as_ref()).collect();
+
+		init_config_system();
+		let ptr = create_cache_fast(&volatile_files)?;
+		Ok(Cache::with_ptr(ptr, volatile_files))
+	}
+
+	fn with_ptr(ptr: UniquePtr<PkgCacheFile>, volatile_files: Vec<&str>) -> Cache {
+		Cache {
+			ptr,
 			depcache: OnceCell::new(),
 			records: OnceCell::new(),
+			dep_graph: OnceCell::new(),
 			pkgmanager: OnceCell::new(),
 			problem_resolver: OnceCell::new(),
+			version_index: OnceCell::new(),
+			volatile_files: volatile_files.iter().map(|f| f.to_string()).collect(),
 			local_debs: volatile_files
 				.into_iter()
 				.filter(|f| f.ends_with(".deb"))
 				.map(|f| f.to_string())
 				.collect(),
-		})
+		}
 	}
 
 	/// Internal Method for generating the package list.
@@ -188,6 +258,83 @@ impl Cache {
 		unsafe { self.begin().raw_iter() }
 	}
 
+	/// Walk the packages in a random order without allocating per package.
+	///
+	/// This is the raw counterpart of [`Cache::iter`] for full cache scans.
+	/// The lists from the yielded packages, such as `versions()`, can be
+	/// walked the same way with [`IntoRawIter::raw_cursor`].
+	///
+	/// ```
+	/// use rust_apt::new_cache;
+	/// use rust_apt::raw::IntoRawIter;
+	///
+	/// let cache = new_cache!().unwrap();
+	/// let mut pkgs = cache.pkg_cursor();
+	///
+	/// while let Some(pkg) = pkgs.next() {
+	///     let mut versions = unsafe { pkg.versions() }.raw_cursor();
+	///     while let Some(ver) = versions.next() {
+	///         println!("{} {}", pkg.name(), ver.version());
+	///     }
+	/// }
+	/// ```
+	pub fn pkg_cursor(&self) -> CursorPkgIterator { unsafe { self.begin().raw_cursor() } }
+
+	/// Gather the name, architecture, versions and [`crate::StateFlags`] of
+	/// every package in a single pass on the C++ side.
+	///
+	/// Use this to scan or filter the whole cache with plain loops; fetch
+	/// the full [`Package`] only for the rows you keep.
+	///
+	/// ```
+	/// use rust_apt::{new_cache, StateFlags};
+	///
+	/// let cache = new_cache!().unwrap();
+	/// let snapshot = cache.snapshot();
+	///
+	/// for row in snapshot.rows_with(StateFlags::Upgradable) {
+	///     println!("{}:{}", snapshot.name(row), snapshot.arch(row));
+	/// }
+	/// ```
+	pub fn snapshot(&self) -> PackageSnapshot {
+		PackageSnapshot {
+			cols: self.package_columns(),
+			cache: self,
+		}
+	}
+
+	/// Get a read only handle to the cache that can be shared between
+	/// threads.
+	///
+	/// The cache is borrowed mutably for as long as the view is alive so
+	/// nothing can mark changes while other threads are reading.
+	///
+	/// ```
+	/// use rust_apt::new_cache;
+	///
+	/// let mut cache = new_cache!().unwrap();
+	/// let view = cache.view();
+	///
+	/// std::thread::scope(|s| {
+	///     for name in ["apt", "dpkg"] {
+	///         let view = &view;
+	///         s.spawn(move || {
+	///             let pkg = view.find_pkg(name).unwrap();
+	///             println!("{} {}", pkg.name(), view.state_flags(&pkg));
+	///         });
+	///     }
+	/// });
+	/// ```
+	pub fn view(&mut self) -> CacheView {
+		// The DepCache and Policy are built on first use,
+		// they must exist before any other thread can get to them.
+		let cache: &Cache = self;
+		CacheView {
+			cache,
+			depcache: cache.depcache(),
+		}
+	}
+
 	/// Get the DepCache
 	pub fn depcache(&self) -> &DepCache {
 		self.depcache
@@ -200,6 +347,27 @@ impl Cache {
 			.get_or_init(|| PackageRecords::new(unsafe { self.create_records() }))
 	}
 
+	/// Create records of their own that lend out borrowed fields, see
+	/// [`RecordReader`].
+	pub fn record_reader(&self) -> RecordReader {
+		RecordReader::new(unsafe { self.create_records() })
+	}
+
+	/// Get the dependency graph of the whole cache.
+	///
+	/// It is built on first use, from the installed and candidate versions
+	/// at that time.
+	pub fn dep_graph(&self) -> &DepGraph { self.dep_graph.get_or_init(|| DepGraph::new(self)) }
+
+	/// Get a package by its [`crate::raw::PkgIterator::id`].
+	///
+	/// This builds [`Cache::dep_graph`] if it doesn't exist yet.
+	pub fn package_by_id(&self, id: u32) -> Option<Package> {
+		let index = self.dep_graph().pkg_index(id)?;
+		// The index was read from this cache, so it is always valid.
+		Some(Package::new(self, unsafe { self.find_pkg_by_index(index) }))
+	}
+
 	/// Get the PkgManager
 	pub fn pkg_manager(&self) -> &PackageManager {
 		self.pkgmanager
@@ -222,103 +390,15 @@ impl Cache {
 
 	/// An iterator of packages in the cache.
 	pub fn packages(&self, sort: &PackageSort) -> impl Iterator<Item = Package> {
-		let mut pkg_list = vec![];
-		for pkg in self.raw_pkgs() {
-			match sort.virtual_pkgs {
-				// Virtual packages are enabled, include them.
-				// This works differently than the rest. I should probably change defaults.
-				Sort::Enable => {},
-				// If disabled and pkg has no versions, exclude
-				Sort::Disable => {
-					if unsafe { pkg.versions().end() } {
-						continue;
-					}
-				},
-				// If reverse and the package has versions, exclude
-				// This section is for if you only want virtual packages
-				Sort::Reverse => {
-					if unsafe { !pkg.versions().end() } {
-						continue;
-					}
-				},
-			}
-
-			match sort.upgradable {
-				// Virtual packages are enabled, include them.
-				Sort::Disable => {},
-				// If disabled and pkg has no versions, exclude
-				Sort::Enable => {
-					// If the package isn't installed, then it can not be upgradable
-					if unsafe { pkg.current_version().end() }
-						|| !self.depcache().is_upgradable(&pkg)
-					{
-						continue;
-					}
-				},
-				// If reverse and the package is installed and upgradable, exclude
-				// This section is for if you only want packages that are not upgradable
-				Sort::Reverse => {
-					if unsafe { !pkg.current_version().end() }
-						&& self.depcache().is_upgradable(&pkg)
-					{
-						continue;
-					}
-				},
-			}
+		let (require, exclude) = sort.flags();
 
-			match sort.installed {
-				// Installed Package is Disabled, so we keep them
-				Sort::Disable => {},
-				Sort::Enable => {
-					if unsafe { pkg.current_version().end() } {
-						continue;
-					}
-				},
-				// Only include installed packages.
-				Sort::Reverse => {
-					if unsafe { !pkg.current_version().end() } {
-						continue;
-					}
-				},
-			}
-
-			match sort.auto_installed {
-				// Installed Package is Disabled, so we keep them
-				Sort::Disable => {},
-				Sort::Enable => {
-					if !self.depcache().is_auto_installed(&pkg) {
-						continue;
-					}
-				},
-				// Only include installed packages.
-				Sort::Reverse => {
-					if self.depcache().is_auto_installed(&pkg) {
-						continue;
-					}
-				},
-			}
-
-			match sort.auto_removable {
-				// auto_removable is Disabled, so we keep them
-				Sort::Disable => {},
-				// If the package is not auto removable skip it.
-				Sort::Enable => {
-					// If the Package isn't auto_removable skip
-					if !self.depcache().is_garbage(&pkg) {
-						continue;
-					}
-				},
-				// If the package is auto removable skip it.
-				Sort::Reverse => {
-					if self.depcache().is_garbage(&pkg) {
-						continue;
-					}
-				},
-			}
-
-			// If this is reached we're clear to include the package.
-			pkg_list.push(pkg);
-		}
+		// The whole sort is checked in a single pass on the C++ side.
+		let mut pkg_list: Vec<_> = self
+			.depcache()
+			.filter_packages(require, exclude)
+			.into_iter()
+			.map(|index| unsafe { self.find_pkg_by_index(index) })
+			.collect();
 
 		if sort.names {
 			pkg_list.sort_by_cached_key(|pkg| pkg.name().to_string());
@@ -355,6 +435,65 @@ impl Cache {
 		Ok(self.ptr.update(progress.mut_status())?)
 	}
 
+	/// Update the package lists like [`Cache::update`], then
+	/// [`Cache::refresh`] so the cache can keep being used.
+	pub fn update_in_place(&mut self, progress: &mut AcquireProgress) -> Result<(), AptErrors> {
+		self.ptr.update(progress.mut_status())?;
+		self.refresh()
+	}
+
+	/// Open the cache again in place, picking up any changes to the dpkg
+	/// status, the package lists and the sources.
+	///
+	/// apt only rebuilds what changed. After an install only the dpkg status
+	/// is merged again on top of `srcpkgcache.bin`, and when nothing changed
+	/// the existing `pkgcache.bin` is used as is. The local files the cache
+	/// was opened with are added again.
+	///
+	/// Every mark is cleared, and the DepCache, records, resolver and
+	/// indexes are built again the next time they are used.
+	///
+	/// The new cache is opened next to the old one, which is only let go
+	/// once it succeeds. On an error the cache is left as it was.
+	///
+	/// apt gives up one hold on its lock each time a cache closes, so
+	/// closing the old one would drop a lock taken with
+	/// [`crate::util::apt_lock`]. If the lock was held before the refresh it
+	/// is taken again afterwards.
+	///
+	/// ```
+	/// use rust_apt::new_cache;
+	///
+	/// let mut cache = new_cache!().unwrap();
+	/// cache.get("apt").unwrap().mark_delete(false);
+	///
+	/// cache.refresh().unwrap();
+	/// assert!(!cache.get("apt").unwrap().marked_delete());
+	/// ```
+	pub fn refresh(&mut self) -> Result<(), AptErrors> {
+		let locked = apt_is_locked();
+		let result = self.reopen();
+		if locked && !apt_is_locked() {
+			apt_lock()?;
+		}
+		result
+	}
+
+	fn reopen(&mut self) -> Result<(), AptErrors> {
+		let volatile_files: Vec<&str> = self.volatile_files.iter().map(|f| f.as_str()).collect();
+		let ptr = create_cache_fast(&volatile_files)?;
+
+		// Everything here points into the old cache, which closes below.
+		self.problem_resolver.take();
+		self.pkgmanager.take();
+		self.records.take();
+		self.version_index.take();
+		self.dep_graph.take();
+		self.depcache.take();
+		self.ptr = ptr;
+		Ok(())
+	}
+
 	/// Mark all packages for upgrade
 	///
 	/// # Example:
@@ -374,6 +513,26 @@ impl Cache {
 			.upgrade(progress.pin().as_mut(), upgrade_type as i32)?)
 	}
 
+	/// Mark all packages for upgrade, and report how long it took and what
+	/// changed.
+	///
+	/// ```
+	/// use rust_apt::cache::Upgrade;
+	/// use rust_apt::new_cache;
+	///
+	/// let cache = new_cache!().unwrap();
+	/// let stats = cache.upgrade_with_stats(Upgrade::FullUpgrade).unwrap();
+	///
+	/// for phase in &stats.phases {
+	///     println!("{}: {:?}", phase.name, phase.elapsed);
+	/// }
+	/// println!("{} to install after {:?}", stats.after.install, stats.total);
+	/// ```
+	pub fn upgrade_with_stats(&self, upgrade_type: Upgrade) -> Result<OpStats, AptErrors> {
+		let depcache = self.depcache();
+		depcache.measure(|progress| depcache.upgrade(progress, upgrade_type as i32))
+	}
+
 	/// Resolve dependencies with the changes marked on all packages. This marks
 	/// additional packages for installation/removal to satisfy the dependency
 	/// chain.
@@ -395,6 +554,23 @@ impl Cache {
 			.resolve(fix_broken, OperationProgress::quiet().pin().as_mut())?)
 	}
 
+	/// Resolve dependencies, and report how long it took and what changed,
+	/// see [`Cache::resolve`].
+	pub fn resolve_with_stats(&self, fix_broken: bool) -> Result<OpStats, AptErrors> {
+		let resolver = self.resolver();
+		self.depcache()
+			.measure(|progress| resolver.resolve(fix_broken, progress))
+	}
+
+	/// Let go of the ProblemResolver, along with every package that was
+	/// protected on it.
+	///
+	/// The resolver is kept between calls to [`Cache::resolve`], and so are
+	/// its protected packages. Tools that mark, resolve and mark again can
+	/// start each round with nothing protected by calling this first. Marks
+	/// on the DepCache are left as they are.
+	pub fn reset_resolver(&mut self) { self.problem_resolver.take(); }
+
 	/// Autoinstall every broken package and run the problem resolver
 	/// Returns false if the problem resolver fails.
 	///
@@ -532,6 +708,27 @@ impl Cache {
 		self,
 		progress: &mut AcquireProgress,
 		install_progress: &mut InstallProgress,
+	) -> Result<(), AptErrors> {
+		self.run_commit(progress, install_progress)
+	}
+
+	/// [`Cache::commit`], then [`Cache::refresh`] so the cache can keep being
+	/// used.
+	///
+	/// On success the cache shows the packages as they are now installed.
+	pub fn commit_in_place(
+		&mut self,
+		progress: &mut AcquireProgress,
+		install_progress: &mut InstallProgress,
+	) -> Result<(), AptErrors> {
+		self.run_commit(progress, install_progress)?;
+		self.refresh()
+	}
+
+	fn run_commit(
+		&self,
+		progress: &mut AcquireProgress,
+		install_progress: &mut InstallProgress,
 	) -> Result<(), AptErrors> {
 		// Lock the whole thing so as to prevent tamper
 		apt_lock()?;
@@ -556,7 +753,8 @@ impl Cache {
 		apt_unlock_inner();
 
 		// Perform the operation.
-		self.do_install(install_progress)?;
+		self.pkg_manager()
+			.do_install(install_progress.pin().as_mut())?;
 
 		// Finally Unlock the whole thing.
 		apt_unlock();
@@ -574,6 +772,50 @@ impl Cache {
 		}))
 	}
 
+	/// Get a single version by `name=version` or `name:arch=version`.
+	///
+	/// Without an architecture the native one is used, like [`Cache::get`].
+	/// The first lookup builds a map of every version in the cache, after
+	/// that each lookup is a single hash.
+	///
+	/// ```
+	/// use rust_apt::new_cache;
+	///
+	/// let cache = new_cache!().unwrap();
+	/// let candidate = cache.get("apt").unwrap().candidate().unwrap();
+	///
+	/// let ver = cache.find_version(&format!("apt={}", candidate.version())).unwrap();
+	/// assert_eq!(ver, candidate);
+	/// ```
+	pub fn find_version(&self, spec: &str) -> Option<Version> {
+		self.version_from_index(self.version_index().find(spec))
+	}
+
+	/// [`Cache::find_version`] for a whole list of specs at once, such as the
+	/// lines of a lock file.
+	///
+	/// The results are in the same order as `specs`.
+	pub fn find_versions(&self, specs: &[&str]) -> Vec<Option<Version>> {
+		self.version_index()
+			.find_many(specs)
+			.into_iter()
+			.map(|index| self.version_from_index(index))
+			.collect()
+	}
+
+	fn version_index(&self) -> &VersionIndex {
+		self.version_index
+			.get_or_init(|| unsafe { self.ptr.version_index() })
+	}
+
+	fn version_from_index(&self, index: u64) -> Option<Version> {
+		if index == 0 {
+			return None;
+		}
+		// The index was read from this cache, so it is always valid.
+		Some(Version::new(unsafe { self.find_ver_by_index(index) }, self))
+	}
+
 	/// An iterator over the packages
 	/// that will be altered when `cache.commit()` is called.
 	///
@@ -581,19 +823,12 @@ impl Cache {
 	/// * [`true`] = Packages will be in alphabetical order
 	/// * [`false`] = Packages will not be sorted by name
 	pub fn get_changes(&self, sort_name: bool) -> impl Iterator<Item = Package> {
-		let mut changed = Vec::new();
-		let depcache = self.depcache();
-
-		for pkg in self.raw_pkgs() {
-			if depcache.marked_install(&pkg)
-				|| depcache.marked_delete(&pkg)
-				|| depcache.marked_upgrade(&pkg)
-				|| depcache.marked_downgrade(&pkg)
-				|| depcache.marked_reinstall(&pkg)
-			{
-				changed.push(pkg);
-			}
-		}
+		let mut changed: Vec<_> = self
+			.depcache()
+			.changed_packages()
+			.into_iter()
+			.map(|index| unsafe { self.find_pkg_by_index(index) })
+			.collect();
 
 		if sort_name {
 			// Sort by cached key seems to be the fastest for what we're doing.
@@ -619,13 +854,230 @@ impl<'a> Iterator for CacheIter<'a> {
 	fn next(&mut self) -> Option<Self::Item> { Some(Package::new(self.cache, self.pkgs.next()?)) }
 }
 
+/// A read only handle to a [`Cache`], see [`Cache::view`].
+///
+/// The view is [`Send`] and [`Sync`]. It hands out raw iterators wrapped in
+/// a [`ViewPtr`], which can be walked from any thread, instead of
+/// [`Package`]s.
+pub struct CacheView<'a> {
+	cache: &'a Cache,
+	depcache: &'a PkgDepCache,
+}
+
+// Every method below only reads from the cache map, policy, and DepCache,
+// all of which were built before the view was created. The mutable borrow
+// in `Cache::view` keeps anyone else from changing them.
+unsafe impl Send for CacheView<'_> {}
+unsafe impl Sync for CacheView<'_> {}
+
+impl<'a> CacheView<'a> {
+	/// Return a package by name and optionally architecture.
+	pub fn find_pkg(&self, name: &str) -> Option<ViewPtr<'a, PkgIterator>> {
+		unsafe { self.cache.find_pkg(name).make_safe().map(ViewPtr::new) }
+	}
+
+	/// Return the package at the offset given by `PkgIterator::index`.
+	///
+	/// # Safety
+	///
+	/// The index must come from this cache, anything else can segfault.
+	pub unsafe fn find_pkg_by_index(&self, index: u64) -> ViewPtr<'a, PkgIterator> {
+		ViewPtr::new(self.cache.find_pkg_by_index(index))
+	}
+
+	/// Walk the packages in a random order, see [`Cache::pkg_cursor`].
+	pub fn pkg_cursor(&self) -> CursorPkgIterator { self.cache.pkg_cursor() }
+
+	/// The priority of the Version as shown in `apt policy`.
+	pub fn priority(&self, ver: &VerIterator) -> i32 { self.cache.priority(ver) }
+
+	/// The candidate version of the package.
+	pub fn candidate(&self, pkg: &PkgIterator) -> Option<ViewPtr<'a, VerIterator>> {
+		let ver = unsafe { self.depcache.candidate_version(pkg) };
+		ver.make_safe().map(ViewPtr::new)
+	}
+
+	/// All of the [`crate::StateFlags`] of the package.
+	pub fn state_flags(&self, pkg: &PkgIterator) -> u32 { self.depcache.state_flags(pkg) }
+
+	/// A snapshot of every package, see [`Cache::snapshot`].
+	pub fn package_columns(&self) -> PackageColumns { self.cache.package_columns() }
+
+	/// The index of every package, see [`CacheView::find_pkg_by_index`].
+	pub fn package_indexes(&self) -> Vec<u64> { self.cache.package_indexes() }
+
+	/// Split the packages between threads, see [`ParPackages`].
+	pub fn par_packages(&self) -> ParPackages { ParPackages::new(self) }
+
+	/// Create a DepCache of its own, starting with the marks of
+	/// [`Cache::depcache`].
+	///
+	/// Changes made to the fork stay in the fork, see [`DepCacheFork`].
+	/// Forks can be made from any thread and are [`Send`], so each what-if
+	/// can run on its own core.
+	pub fn fork_depcache(&self) -> Result<DepCacheFork<'a>, AptErrors> {
+		let ptr = unsafe { self.cache.ptr.fork_depcache()? };
+		Ok(DepCacheFork::new(ptr))
+	}
+
+	/// Create new records for the calling thread.
+	///
+	/// Records keep their place in the index files, so they are never
+	/// shared. Each thread should create its own and keep it.
+	pub fn records(&self) -> PackageRecords {
+		PackageRecords::new(unsafe { self.cache.create_records() })
+	}
+
+	/// Create a [`RecordReader`] for the calling thread.
+	pub fn record_reader(&self) -> RecordReader<'a> {
+		RecordReader::new(unsafe { self.cache.create_records() })
+	}
+}
+
+mod sealed {
+	pub trait Sealed {}
+}
+
+/// The raw iterators that point only into the cache map.
+///
+/// This is sealed, see [`ViewPtr`].
+pub trait ViewSafe: sealed::Sealed + cxx::memory::UniquePtrTarget {}
+
+macro_rules! impl_view_safe {
+	($($ty:ty),* $(,)?) => {
+		$(
+			impl sealed::Sealed for $ty {}
+			impl ViewSafe for $ty {}
+		)*
+	};
+}
+
+impl_view_safe!(
+	crate::raw::PkgIterator,
+	crate::raw::VerIterator,
+	crate::raw::DepIterator,
+	crate::raw::PrvIterator,
+	crate::raw::VerFileIterator,
+	crate::raw::DescIterator,
+	crate::raw::PkgFileIterator,
+);
+
+/// A raw iterator handed out by a [`CacheView`].
+///
+/// The raw iterators themselves are neither [`Send`] nor [`Sync`], as
+/// nothing stops the [`Cache`] they point into from being marked or
+/// refreshed on another thread. A ViewPtr can't outlive the view it came
+/// from, and the view keeps the cache borrowed mutably the whole time, so it
+/// is safe to move and share between threads.
+pub struct ViewPtr<'a, T: ViewSafe> {
+	ptr: UniquePtr<T>,
+	view: PhantomData<&'a Cache>,
+}
+
+impl<'a, T: ViewSafe> ViewPtr<'a, T> {
+	fn new(ptr: UniquePtr<T>) -> ViewPtr<'a, T> {
+		ViewPtr {
+			ptr,
+			view: PhantomData,
+		}
+	}
+
+	/// Get a pinned mutable reference to the iterator, to move it in place.
+	pub fn pin_mut(&mut self) -> Pin<&mut T> { self.ptr.pin_mut() }
+}
+
+impl<T: ViewSafe> Deref for ViewPtr<'_, T> {
+	type Target = T;
+
+	fn deref(&self) -> &T { &self.ptr }
+}
+
+// The iterators only ever read from the cache map, which can not change
+// while the view it was handed out by is alive.
+unsafe impl<T: ViewSafe> Send for ViewPtr<'_, T> {}
+unsafe impl<T: ViewSafe> Sync for ViewPtr<'_, T> {}
+
+/// A [`PackageColumns`] tied to the [`Cache`] it was taken from.
+///
+/// Changes marked after the snapshot was taken are not reflected in it.
+pub struct PackageSnapshot<'a> {
+	cols: PackageColumns,
+	cache: &'a Cache,
+}
+
+impl<'a> PackageSnapshot<'a> {
+	/// The number of packages in the snapshot.
+	pub fn len(&self) -> usize { self.cols.index.len() }
+
+	/// Returns [`true`] if the cache has no packages.
+	pub fn is_empty(&self) -> bool { self.cols.index.is_empty() }
+
+	/// The name of the package in `row`.
+	pub fn name(&self, row: usize) -> &str {
+		let offsets = &self.cols.name_offsets;
+		&self.cols.names[offsets[row] as usize..offsets[row + 1] as usize]
+	}
+
+	/// The architecture of the package in `row`.
+	pub fn arch(&self, row: usize) -> &str { &self.cols.arches[self.cols.arch[row] as usize] }
+
+	/// The [`crate::StateFlags`] of the package in `row`.
+	pub fn flags(&self, row: usize) -> u32 { self.cols.flags[row] }
+
+	/// The rows whose flags contain every bit of `mask`.
+	pub fn rows_with(&self, mask: u32) -> impl Iterator<Item = usize> + '_ {
+		self.cols
+			.flags
+			.iter()
+			.enumerate()
+			.filter(move |(_, flags)| *flags & mask == mask)
+			.map(|(row, _)| row)
+	}
+
+	/// Get the full [`Package`] for `row`.
+	pub fn package(&self, row: usize) -> Package<'a> {
+		// The index was read from this cache, so it is always valid.
+		Package::new(self.cache, unsafe {
+			self.cache.find_pkg_by_index(self.cols.index[row])
+		})
+	}
+
+	/// The raw columns.
+	pub fn columns(&self) -> &PackageColumns { &self.cols }
+}
+
 #[cxx::bridge]
 pub(crate) mod raw {
 	impl UniquePtr<PkgRecords> {}
 
+	/// Package data laid out in columns, one row per package.
+	///
+	/// Version columns hold the offset used by `VerIterator::index`,
+	/// `0` means there is no such version.
+	#[derive(Debug)]
+	struct PackageColumns {
+		/// The offset used by `PkgIterator::index`.
+		pub index: Vec<u64>,
+		/// Row `n` is `names[name_offsets[n]..name_offsets[n + 1]]`.
+		pub name_offsets: Vec<u32>,
+		/// Every package name, concatenated.
+		pub names: String,
+		/// Position of the row's architecture in `arches`.
+		pub arch: Vec<u32>,
+		/// Each distinct architecture.
+		pub arches: Vec<String>,
+		/// The installed version.
+		pub current_ver: Vec<u64>,
+		/// The candidate version.
+		pub candidate_ver: Vec<u64>,
+		/// The [`crate::StateFlags`] of the package.
+		pub flags: Vec<u32>,
+	}
+
 	unsafe extern "C++" {
 		include!("rust-apt/apt-pkg-c/cache.h");
 		type PkgCacheFile;
+		type VersionIndex;
 
 		type PkgIterator = crate::raw::PkgIterator;
 		type VerIterator = crate::raw::VerIterator;
@@ -639,6 +1091,10 @@ pub(crate) mod raw {
 		/// Create the CacheFile.
 		pub fn create_cache(volatile_files: &[&str]) -> Result<UniquePtr<PkgCacheFile>>;
 
+		/// Create the CacheFile, mapping `pkgcache.bin` without validating
+		/// it if nothing it is built from has changed since.
+		pub fn create_cache_fast(volatile_files: &[&str]) -> Result<UniquePtr<PkgCacheFile>>;
+
 		/// Update the package lists, handle errors and return a Result.
 		pub fn update(self: &PkgCacheFile, progress: Pin<&mut AcqTextStatus>) -> Result<()>;
 
@@ -656,6 +1112,14 @@ pub(crate) mod raw {
 		/// The returned UniquePtr cannot outlive the cache.
 		unsafe fn create_depcache(self: &PkgCacheFile) -> UniquePtr<PkgDepCache>;
 
+		/// Create a new DepCache that is not shared with the cache, with the
+		/// marks of the shared one copied over.
+		///
+		/// # Safety
+		///
+		/// The returned UniquePtr cannot outlive the cache.
+		unsafe fn fork_depcache(self: &PkgCacheFile) -> Result<UniquePtr<PkgDepCache>>;
+
 		/// Return a pointer to PkgRecords.
 		///
 		/// # Safety
@@ -694,5 +1158,53 @@ pub(crate) mod raw {
 		///
 		/// The returned UniquePtr cannot outlive the cache.
 		unsafe fn begin(self: &PkgCacheFile) -> UniquePtr<PkgIterator>;
+
+		/// Return the package at the offset given by `PkgIterator::index`.
+		///
+		/// # Safety
+		///
+		/// The index must come from this cache, anything else can segfault.
+		///
+		/// The returned UniquePtr cannot outlive the cache.
+		unsafe fn find_pkg_by_index(self: &PkgCacheFile, index: u64) -> UniquePtr<PkgIterator>;
+
+		/// Return the version at the offset given by `VerIterator::index`.
+		///
+		/// # Safety
+		///
+		/// The index must come from this cache, anything else can segfault.
+		///
+		/// The returned UniquePtr cannot outlive the cache.
+		unsafe fn find_ver_by_index(self: &PkgCacheFile, index: u64) -> UniquePtr<VerIterator>;
+
+		/// A hash of the cache counts and the name, size and mtime of every
+		/// package file.
+		///
+		/// This changes whenever apt would consider the cache out of date.
+		pub fn fingerprint(self: &PkgCacheFile) -> u64;
+
+		/// The index of every package, in the same order as
+		/// [`PkgCacheFile::begin`].
+		pub fn package_indexes(self: &PkgCacheFile) -> Vec<u64>;
+
+		/// The `VerIterator::index` of every version, package by package.
+		pub fn version_indexes(self: &PkgCacheFile) -> Vec<u64>;
+
+		/// Map every version in the cache by `name:arch=version`.
+		///
+		/// # Safety
+		///
+		/// The returned UniquePtr cannot outlive the cache.
+		unsafe fn version_index(self: &PkgCacheFile) -> UniquePtr<VersionIndex>;
+
+		/// The `VerIterator::index` of the version for a `name=version` or
+		/// `name:arch=version` spec, 0 if there is none.
+		pub fn find(self: &VersionIndex, spec: &str) -> u64;
+
+		/// [`VersionIndex::find`] for every spec.
+		pub fn find_many(self: &VersionIndex, specs: &[&str]) -> Vec<u64>;
+
+		/// Gather the columns of [`PackageColumns`] in one walk of the cache.
+		pub fn package_columns(self: &PkgCacheFile) -> PackageColumns;
 	}
 }
@@ -30,26 +30,209 @@
 //!
 //! The Candidate version is what is shown the 'Install Version' field.
 
-use cxx::UniquePtr;
+use std::cell::{OnceCell, RefCell};
+use std::marker::PhantomData;
+use std::ops::Deref;
+use std::pin::Pin;
+use std::rc::Rc;
+use std::time::Instant;
 
+use cxx::{Exception, UniquePtr};
+
+use crate::cache::Upgrade;
 use crate::error::AptErrors;
-use crate::progress::OperationProgress;
-use crate::raw::PkgDepCache;
+use crate::progress::{MarkCounts, OpStats, OperationProgress, StatsProgress};
+use crate::raw::{
+	create_problem_resolver, DepCacheCheckpoint, PkgDepCache, PkgIterator, ProblemResolver,
+};
 use crate::util::DiskSpace;
+use crate::{Cache, Package};
+
+/// StateFlags defined in depcache.h
+///
+/// Returned by [`crate::raw::PkgDepCache::state_flags`] and
+/// [`crate::cache::PackageColumns::flags`].
+#[allow(non_upper_case_globals, non_snake_case)]
+pub mod StateFlags {
+	/// The package is not purely virtual.
+	pub const HasVersions: u32 = 1 << 0;
+	/// A version of the package is installed.
+	pub const Installed: u32 = 1 << 1;
+	/// The package is installed and a newer candidate exists.
+	pub const Upgradable: u32 = 1 << 2;
+	pub const Auto: u32 = 1 << 3;
+	pub const Garbage: u32 = 1 << 4;
+	pub const NewInstall: u32 = 1 << 5;
+	pub const Upgrade: u32 = 1 << 6;
+	pub const Delete: u32 = 1 << 7;
+	pub const Purge: u32 = 1 << 8;
+	pub const Keep: u32 = 1 << 9;
+	pub const Downgrade: u32 = 1 << 10;
+	pub const ReInstall: u32 = 1 << 11;
+	pub const NowBroken: u32 = 1 << 12;
+	pub const InstBroken: u32 = 1 << 13;
+	pub const Essential: u32 = 1 << 14;
+}
+
+/// A single mark for [`DepCache::mark_many`].
+///
+/// Each variant matches the `Package` method of the same name.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum Mark {
+	/// See [`Package::mark_install`].
+	Install { auto_inst: bool, from_user: bool },
+	/// See [`Package::mark_delete`].
+	Delete { purge: bool },
+	/// See [`Package::mark_keep`].
+	Keep,
+	/// See [`Package::mark_reinstall`].
+	ReInstall(bool),
+	/// See [`Package::mark_auto`].
+	Auto(bool),
+}
 
 /// Dependency Extension data for the cache.
 pub struct DepCache {
 	pub(crate) ptr: UniquePtr<PkgDepCache>,
+	/// The `gen` counter of the PkgDepCache, which is never moved.
+	generation: *const u64,
 }
 
 impl DepCache {
-	pub fn new(ptr: UniquePtr<PkgDepCache>) -> DepCache { DepCache { ptr } }
+	pub fn new(ptr: UniquePtr<PkgDepCache>) -> DepCache {
+		let generation = ptr.generation_ptr();
+		DepCache { ptr, generation }
+	}
+
+	/// A counter bumped by every call that can change the state of a
+	/// package.
+	///
+	/// State read at one generation is still current as long as this
+	/// hasn't changed. It is read straight from the DepCache without
+	/// calling into C++, see [`Package::state_flags`].
+	pub fn generation(&self) -> u64 {
+		// The pointer is into the PkgDepCache that `ptr` keeps alive.
+		unsafe { *self.generation }
+	}
 
 	/// Clear any marked changes in the DepCache.
 	pub fn clear_marked(&self) -> Result<(), AptErrors> {
 		Ok(self.init(OperationProgress::quiet().pin().as_mut())?)
 	}
 
+	/// Save the state of every package, so marks made afterwards can be
+	/// undone with [`DepCache::rollback`].
+	///
+	/// ```
+	/// use rust_apt::new_cache;
+	///
+	/// let cache = new_cache!().unwrap();
+	/// let depcache = cache.depcache();
+	/// let checkpoint = depcache.checkpoint();
+	///
+	/// cache.get("neovim").unwrap().mark_install(true, true);
+	/// println!("Would install {} packages", depcache.install_count());
+	///
+	/// depcache.rollback(&checkpoint).unwrap();
+	/// assert_eq!(depcache.install_count(), 0);
+	/// ```
+	pub fn checkpoint(&self) -> Checkpoint {
+		Checkpoint {
+			ptr: unsafe { self.ptr.checkpoint() },
+			depcache: PhantomData,
+		}
+	}
+
+	/// Put every package that changed since `checkpoint` back the way it
+	/// was, returning how many packages were restored.
+	///
+	/// This is much cheaper than [`DepCache::clear_marked`] when only a few
+	/// packages changed, and can go back to any earlier state. The same
+	/// checkpoint can be rolled back to more than once.
+	pub fn rollback(&self, checkpoint: &Checkpoint) -> Result<u32, AptErrors> {
+		Ok(self.ptr.rollback(&checkpoint.ptr)?)
+	}
+
+	/// Apply many marks at once, returning whether each one was successful.
+	///
+	/// Marking a package on its own sweeps the whole cache for garbage
+	/// afterwards. Here all of the marks are made within one action group, so
+	/// the sweep only happens once at the end.
+	///
+	/// ```
+	/// use rust_apt::{new_cache, Mark};
+	///
+	/// let cache = new_cache!().unwrap();
+	/// let apt = cache.get("apt").unwrap();
+	/// let dpkg = cache.get("dpkg").unwrap();
+	///
+	/// let done = cache.depcache().mark_many(&[
+	///     (&apt, Mark::ReInstall(true)),
+	///     (&dpkg, Mark::Keep),
+	/// ]);
+	/// assert_eq!(done, [true, true]);
+	/// ```
+	pub fn mark_many(&self, marks: &[(&Package, Mark)]) -> Vec<bool> {
+		// The action group is released before anything it points to can drop.
+		let mut action_group = unsafe { self.action_group() };
+
+		let done = marks
+			.iter()
+			.map(|(pkg, mark)| match *mark {
+				Mark::Install {
+					auto_inst,
+					from_user,
+				} => self.mark_install(pkg, auto_inst, from_user),
+				Mark::Delete { purge } => self.mark_delete(pkg, purge),
+				Mark::Keep => self.mark_keep(pkg),
+				Mark::ReInstall(reinstall) => {
+					self.mark_reinstall(pkg, reinstall);
+					true
+				},
+				Mark::Auto(auto) => {
+					self.mark_auto(pkg, auto);
+					true
+				},
+			})
+			.collect();
+
+		action_group.pin_mut().release();
+		done
+	}
+
+	/// The install, delete, keep and broken counts in one go.
+	pub fn mark_counts(&self) -> MarkCounts {
+		MarkCounts {
+			install: self.install_count(),
+			delete: self.delete_count(),
+			keep: self.keep_count(),
+			broken: self.broken_count(),
+		}
+	}
+
+	/// Run `f` with a progress that times each operation, and count what it
+	/// changed.
+	pub(crate) fn measure<F>(&self, f: F) -> Result<OpStats, AptErrors>
+	where
+		F: FnOnce(Pin<&mut OperationProgress>) -> Result<(), Exception>,
+	{
+		let phases = Rc::new(RefCell::new(Vec::new()));
+		let before = self.mark_counts();
+		let start = Instant::now();
+
+		let mut progress = OperationProgress::new(StatsProgress::new(phases.clone()));
+		f(progress.pin())?;
+		// Dropping the progress closes the last phase.
+		drop(progress);
+
+		Ok(OpStats {
+			total: start.elapsed(),
+			phases: phases.take(),
+			before,
+			after: self.mark_counts(),
+		})
+	}
+
 	/// The amount of space required for installing/removing the packages."
 	///
 	/// i.e. the Installed-Size of all packages marked for installation"
@@ -63,6 +246,112 @@ impl DepCache {
 	}
 }
 
+/// The state of every package at one point, see [`DepCache::checkpoint`].
+pub struct Checkpoint<'a> {
+	ptr: UniquePtr<DepCacheCheckpoint>,
+	depcache: PhantomData<&'a DepCache>,
+}
+
+/// A [`DepCache`] of its own, see [`crate::cache::CacheView::fork_depcache`].
+///
+/// Marking, upgrading and resolving on a fork never touches the DepCache of
+/// the [`Cache`] or any other fork, so each fork can be moved to its own
+/// thread and worked on at the same time. Use the raw mark functions
+/// through [`Deref`], the ones on [`Package`] always go to the shared
+/// DepCache.
+///
+/// ```
+/// use rust_apt::cache::Upgrade;
+/// use rust_apt::new_cache;
+///
+/// let mut cache = new_cache!().unwrap();
+/// let view = cache.view();
+///
+/// let counts: Vec<u32> = std::thread::scope(|s| {
+///     let workers: Vec<_> = [Upgrade::FullUpgrade, Upgrade::SafeUpgrade]
+///         .into_iter()
+///         .map(|upgrade| {
+///             let fork = view.fork_depcache().unwrap();
+///             s.spawn(move || {
+///                 fork.upgrade(upgrade).unwrap();
+///                 fork.install_count()
+///             })
+///         })
+///         .collect();
+///     workers.into_iter().map(|w| w.join().unwrap()).collect()
+/// });
+/// println!("{counts:?}");
+/// ```
+pub struct DepCacheFork<'a> {
+	// Declared first so it is dropped before the DepCache it points to.
+	resolver: OnceCell<UniquePtr<ProblemResolver>>,
+	depcache: DepCache,
+	cache: PhantomData<&'a Cache>,
+}
+
+// The fork owns its DepCache and resolver, and only reads the cache map and
+// policy under them. Forks are only made by `CacheView::fork_depcache`, so
+// they live inside the mutable borrow of `Cache::view` and nothing can change
+// the map or policy until every fork is gone.
+unsafe impl Send for DepCacheFork<'_> {}
+
+impl<'a> DepCacheFork<'a> {
+	pub(crate) fn new(ptr: UniquePtr<PkgDepCache>) -> DepCacheFork<'a> {
+		DepCacheFork {
+			resolver: OnceCell::new(),
+			depcache: DepCache::new(ptr),
+			cache: PhantomData,
+		}
+	}
+
+	/// Get the ProblemResolver of the fork.
+	pub fn resolver(&self) -> &ProblemResolver {
+		self.resolver
+			.get_or_init(|| unsafe { create_problem_resolver(&self.depcache) })
+	}
+
+	/// Protect a package's state for when [`DepCacheFork::resolve`] is
+	/// called.
+	pub fn protect(&self, pkg: &PkgIterator) { self.resolver().protect(pkg) }
+
+	/// Resolve dependencies on the fork, see [`Cache::resolve`].
+	pub fn resolve(&self, fix_broken: bool) -> Result<(), AptErrors> {
+		Ok(self
+			.resolver()
+			.resolve(fix_broken, OperationProgress::quiet().pin().as_mut())?)
+	}
+
+	/// Let go of the fork's ProblemResolver and its protected packages, see
+	/// [`Cache::reset_resolver`].
+	pub fn reset_resolver(&mut self) { self.resolver.take(); }
+
+	/// Resolve dependencies on the fork, see [`Cache::resolve_with_stats`].
+	pub fn resolve_with_stats(&self, fix_broken: bool) -> Result<OpStats, AptErrors> {
+		let resolver = self.resolver();
+		self.measure(|progress| resolver.resolve(fix_broken, progress))
+	}
+
+	/// Mark all packages for upgrade on the fork, see
+	/// [`Cache::upgrade_with_stats`].
+	pub fn upgrade_with_stats(&self, upgrade_type: Upgrade) -> Result<OpStats, AptErrors> {
+		self.measure(|progress| self.depcache.upgrade(progress, upgrade_type as i32))
+	}
+
+	/// Mark all packages for upgrade on the fork, see [`Cache::upgrade`].
+	pub fn upgrade(&self, upgrade_type: Upgrade) -> Result<(), AptErrors> {
+		let mut progress = OperationProgress::quiet();
+		Ok(self
+			.depcache
+			.upgrade(progress.pin().as_mut(), upgrade_type as i32)?)
+	}
+}
+
+impl Deref for DepCacheFork<'_> {
+	type Target = DepCache;
+
+	fn deref(&self) -> &DepCache { &self.depcache }
+}
+
 #[cxx::bridge]
 pub(crate) mod raw {
 	impl UniquePtr<PkgDepCache> {}
@@ -100,6 +389,8 @@ pub(crate) mod raw {
 		/// action_group.pin_mut().release();
 		/// ```
 		type ActionGroup;
+		/// The saved state of every package in a DepCache.
+		type DepCacheCheckpoint;
 		type PkgIterator = crate::iterators::PkgIterator;
 		type VerIterator = crate::iterators::VerIterator;
 		type DepIterator = crate::iterators::DepIterator;
@@ -141,6 +432,32 @@ pub(crate) mod raw {
 		/// Check if the package is upgradable.
 		pub fn is_upgradable(self: &PkgDepCache, pkg: &PkgIterator) -> bool;
 
+		/// Where the counter bumped by every call that can change the state
+		/// of a package is kept.
+		///
+		/// Use `DepCache::generation`, which reads it.
+		pub fn generation_ptr(self: &PkgDepCache) -> *const u64;
+
+		/// Return every [`crate::StateFlags`] of the package at once.
+		///
+		/// Prefer this to calling several of the `is_*` and `marked_*`
+		/// methods, which each look up the package state again.
+		pub fn state_flags(self: &PkgDepCache, pkg: &PkgIterator) -> u32;
+
+		/// Return the index of every package whose [`crate::StateFlags`]
+		/// contain all of `require` and none of `exclude`.
+		///
+		/// The indexes can be turned back into packages with
+		/// [`crate::raw::PkgCacheFile::find_pkg_by_index`].
+		pub fn filter_packages(self: &PkgDepCache, require: u32, exclude: u32) -> Vec<u64>;
+
+		/// Return the index of every package marked to be installed, removed,
+		/// upgraded, downgraded or reinstalled.
+		///
+		/// The cache is only scanned again after the
+		/// `DepCache::generation` changes.
+		pub fn changed_packages(self: &PkgDepCache) -> Vec<u64>;
+
 		/// Is the Package auto installed? Packages marked as auto installed are
 		/// usually dependencies.
 		pub fn is_auto_installed(self: &PkgDepCache, pkg: &PkgIterator) -> bool;
@@ -289,6 +606,19 @@ pub(crate) mod raw {
 		/// Is the Package to be installed broken?
 		pub fn is_inst_broken(self: &PkgDepCache, pkg: &PkgIterator) -> bool;
 
+		/// Save the state of every package.
+		///
+		/// # Safety
+		///
+		/// The returned UniquePtr cannot outlive the cache.
+		unsafe fn checkpoint(self: &PkgDepCache) -> UniquePtr<DepCacheCheckpoint>;
+
+		/// Restore the packages that changed since `checkpoint`, returning
+		/// how many were restored.
+		///
+		/// Returns an Error if the checkpoint belongs to another DepCache.
+		pub fn rollback(self: &PkgDepCache, checkpoint: &DepCacheCheckpoint) -> Result<u32>;
+
 		/// The number of packages marked for installation.
 		pub fn install_count(self: &PkgDepCache) -> u32;
 
@@ -0,0 +1,229 @@
+//! A compact dependency graph of the whole cache.
+//!
+//! The graph is built once, in a single pass on the C++ side, and stores
+//! the dependencies of every version as compressed rows indexed by
+//! [`crate::raw::PkgIterator::id`]. Forward and reverse lookups are then
+//! plain slices, and closures over thousands of packages never cross the
+//! FFI boundary.
+//!
+//! ```
+//! use rust_apt::graph::{DepFilter, Direction};
+//! use rust_apt::{new_cache, DepType};
+//!
+//! let cache = new_cache!().unwrap();
+//! let graph = cache.dep_graph();
+//! let libc = cache.get("libc6").unwrap();
+//!
+//! // Everything whose installed version needs libc6, directly or not.
+//! let filter = DepFilter::types(&[DepType::Depends, DepType::PreDepends]).installed();
+//! for id in graph.closure([libc.id()], Direction::Reverse, &filter) {
+//!     println!("{}", cache.package_by_id(id).unwrap().name());
+//! }
+//! ```
+use std::collections::VecDeque;
+
+use crate::{Cache, DepType};
+
+/// EdgeFlags defined in graph.h
+///
+/// Which version of the parent package an edge comes from.
+#[allow(non_upper_case_globals, non_snake_case)]
+pub mod EdgeFlags {
+	/// The edge is a dependency of the installed version.
+	pub const Installed: u8 = 1 << 4;
+	/// The edge is a dependency of the candidate version.
+	pub const Candidate: u8 = 1 << 5;
+}
+
+/// Which way to follow the edges.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum Direction {
+	/// From a package to what it depends on.
+	Forward,
+	/// From a package to what depends on it.
+	Reverse,
+}
+
+/// A single dependency from one package to another.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct Edge {
+	/// The ID of the package on the other end of the edge.
+	pub id: u32,
+	info: u8,
+}
+
+impl Edge {
+	/// The type of the dependency.
+	pub fn dep_type(&self) -> DepType { DepType::from(self.info & 0x0F) }
+
+	/// The [`EdgeFlags`] of the edge.
+	pub fn flags(&self) -> u8 { self.info & 0xF0 }
+}
+
+/// Select which edges to follow.
+#[derive(Debug, Clone, Copy)]
+pub struct DepFilter {
+	types: u16,
+	flags: u8,
+}
+
+impl DepFilter {
+	/// Follow every edge.
+	pub fn all() -> DepFilter {
+		DepFilter {
+			types: u16::MAX,
+			flags: 0,
+		}
+	}
+
+	/// Only follow edges of these dependency types.
+	pub fn types(types: &[DepType]) -> DepFilter {
+		DepFilter {
+			types: types.iter().fold(0, |mask, t| mask | 1 << (*t as u8)),
+			flags: 0,
+		}
+	}
+
+	/// Only follow edges from installed versions.
+	pub fn installed(mut self) -> Self {
+		self.flags |= EdgeFlags::Installed;
+		self
+	}
+
+	/// Only follow edges from candidate versions.
+	///
+	/// Combined with [`DepFilter::installed`] an edge from either is
+	/// followed.
+	pub fn candidate(mut self) -> Self {
+		self.flags |= EdgeFlags::Candidate;
+		self
+	}
+
+	/// Returns [`true`] if the edge should be followed.
+	pub fn matches(&self, edge: &Edge) -> bool {
+		self.types & (1 << (edge.info & 0x0F)) != 0
+			&& (self.flags == 0 || edge.info & self.flags != 0)
+	}
+}
+
+/// The dependency graph of every version in the cache.
+///
+/// Get it from [`Cache::dep_graph`]. It reflects the installed and
+/// candidate versions at the time it was built.
+pub struct DepGraph {
+	data: raw::DepGraphData,
+}
+
+impl DepGraph {
+	pub fn new(cache: &Cache) -> DepGraph {
+		DepGraph {
+			data: raw::build_dep_graph(cache),
+		}
+	}
+
+	/// The number of packages, IDs go from 0 up to this.
+	pub fn len(&self) -> usize { self.data.pkg_index.len() }
+
+	/// Returns [`true`] if the cache has no packages.
+	pub fn is_empty(&self) -> bool { self.data.pkg_index.is_empty() }
+
+	/// The offset used by `PkgIterator::index` of the package `id`.
+	pub fn pkg_index(&self, id: u32) -> Option<u64> {
+		self.data.pkg_index.get(id as usize).copied()
+	}
+
+	/// The dependencies of every version of the package `id`.
+	///
+	/// There is an edge for each dependency of each version, so the same
+	/// package can show up more than once.
+	pub fn depends(&self, id: u32) -> impl Iterator<Item = Edge> + '_ {
+		self.edges(id, Direction::Forward)
+	}
+
+	/// The versions that depend on the package `id`, as edges back to their
+	/// parent packages.
+	pub fn rdepends(&self, id: u32) -> impl Iterator<Item = Edge> + '_ {
+		self.edges(id, Direction::Reverse)
+	}
+
+	/// The edges of `id` in `direction`.
+	pub fn edges(&self, id: u32, direction: Direction) -> impl Iterator<Item = Edge> + '_ {
+		let (offsets, nodes, info) = match direction {
+			Direction::Forward => (
+				&self.data.fwd_offsets,
+				&self.data.fwd_nodes,
+				&self.data.fwd_info,
+			),
+			Direction::Reverse => (
+				&self.data.rev_offsets,
+				&self.data.rev_nodes,
+				&self.data.rev_info,
+			),
+		};
+
+		let id = id as usize;
+		let range = match (offsets.get(id), offsets.get(id + 1)) {
+			(Some(start), Some(end)) => *start as usize..*end as usize,
+			_ => 0..0,
+		};
+		range.map(move |slot| Edge {
+			id: nodes[slot],
+			info: info[slot],
+		})
+	}
+
+	/// Every package reachable from `roots` following the edges that match
+	/// `filter`, not including the roots themselves unless they are
+	/// reached again.
+	///
+	/// IDs are returned in the order they were first reached.
+	pub fn closure<I>(&self, roots: I, direction: Direction, filter: &DepFilter) -> Vec<u32>
+	where
+		I: IntoIterator<Item = u32>,
+	{
+		let mut seen = vec![false; self.len()];
+		let mut queue: VecDeque<u32> = roots.into_iter().collect();
+		let mut found = Vec::new();
+
+		while let Some(id) = queue.pop_front() {
+			for edge in self.edges(id, direction) {
+				let next = edge.id as usize;
+				if next < seen.len() && !seen[next] && filter.matches(&edge) {
+					seen[next] = true;
+					found.push(edge.id);
+					queue.push_back(edge.id);
+				}
+			}
+		}
+		found
+	}
+}
+
+#[cxx::bridge]
+pub(crate) mod raw {
+	/// The dependency graph as compressed rows, indexed by package ID.
+	///
+	/// Row `n` of the forward graph is
+	/// `fwd_nodes[fwd_offsets[n]..fwd_offsets[n + 1]]`, the same goes for
+	/// the reverse graph. The low 4 bits of each info byte are the
+	/// dependency type, the rest are [`super::EdgeFlags`].
+	struct DepGraphData {
+		/// The offset used by `PkgIterator::index` of each package.
+		pub pkg_index: Vec<u64>,
+		pub fwd_offsets: Vec<u32>,
+		pub fwd_nodes: Vec<u32>,
+		pub fwd_info: Vec<u8>,
+		pub rev_offsets: Vec<u32>,
+		pub rev_nodes: Vec<u32>,
+		pub rev_info: Vec<u8>,
+	}
+
+	unsafe extern "C++" {
+		include!("rust-apt/apt-pkg-c/graph.h");
+
+		type PkgCacheFile = crate::raw::PkgCacheFile;
+
+		/// Build the dependency graph of every version in the cache.
+		pub fn build_dep_graph(cache: &PkgCacheFile) -> DepGraphData;
+	}
+}
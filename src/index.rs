@@ -0,0 +1,264 @@
+//! Sidecar indexes from a record field to the versions that have it.
+//!
+//! Answering "every version maintained by X" normally means parsing every
+//! record. A [`FieldIndex`] does that once, saves the result next to
+//! `pkgcache.bin`, and is thrown away by the same checks that make apt
+//! rebuild the cache.
+//!
+//! ```
+//! use rust_apt::index::FieldIndex;
+//! use rust_apt::new_cache;
+//! use rust_apt::records::RecordField;
+//!
+//! let cache = new_cache!().unwrap();
+//! let index = FieldIndex::build(&cache, RecordField::Source);
+//!
+//! for ver in index.get("apt") {
+//!     println!("{} {}", ver.parent().name(), ver.version());
+//! }
+//! ```
+use std::collections::BTreeMap;
+use std::fs;
+use std::path::{Path, PathBuf};
+
+use crate::config::Config;
+use crate::error::AptErrors;
+use crate::records::RecordField;
+use crate::{Cache, Version};
+
+const MAGIC: &[u8; 8] = b"RAPTIDX\x01";
+
+/// magic, fingerprint, key count, field length and the table, versions and
+/// strings offsets.
+const HEADER_SIZE: usize = 36;
+
+/// Each key is its string offset and length followed by the position and
+/// number of its versions.
+const ENTRY_SIZE: usize = 16;
+
+/// Maps the values of one record field to version indexes.
+///
+/// The index only ever holds the raw bytes as they are laid out on disk,
+/// lookups binary search them in place.
+pub struct FieldIndex<'a> {
+	cache: &'a Cache,
+	data: Vec<u8>,
+	keys: usize,
+	table: usize,
+	versions: usize,
+	strings: usize,
+}
+
+impl<'a> FieldIndex<'a> {
+	/// Build the index by reading `field` from the record of every version.
+	///
+	/// [`RecordField::Source`] is taken from the cache instead, so it is
+	/// quick to build and always has the bare source package name.
+	pub fn build(cache: &'a Cache, field: &str) -> FieldIndex<'a> {
+		let mut map: BTreeMap<String, Vec<u32>> = BTreeMap::new();
+		let versions: Vec<Version> = cache.iter().flat_map(|pkg| pkg.versions()).collect();
+
+		if field == RecordField::Source {
+			for ver in &versions {
+				map.entry(ver.source_name().to_string())
+					.or_default()
+					.push(ver.index() as u32);
+			}
+		} else {
+			let mut reader = cache.record_reader();
+			reader.for_each_sorted(&versions, |ver, records| {
+				if let Some(value) = records.get_field(field) {
+					map.entry(value.to_string())
+						.or_default()
+						.push(ver.index() as u32);
+				}
+			});
+		}
+
+		let data = encode(cache.fingerprint(), field, &map);
+		FieldIndex::from_bytes(cache, field, data).expect("Freshly built index is invalid")
+	}
+
+	/// Open a saved index, or build and save it if the saved one is missing
+	/// or out of date.
+	///
+	/// Failing to save is not an error, as the cache directory is usually
+	/// only writable by root. The index is simply built again next time.
+	pub fn open_or_build<P: AsRef<Path>>(cache: &'a Cache, field: &str, path: P) -> FieldIndex<'a> {
+		if let Ok(index) = FieldIndex::open(cache, field, &path) {
+			return index;
+		}
+		let index = FieldIndex::build(cache, field);
+		let _ = index.save(&path);
+		index
+	}
+
+	/// Open a saved index.
+	///
+	/// Returns an error if the file can't be read, is for a different field,
+	/// or was built from a cache that has since changed.
+	pub fn open<P: AsRef<Path>>(
+		cache: &'a Cache,
+		field: &str,
+		path: P,
+	) -> Result<FieldIndex<'a>, AptErrors> {
+		let path = path.as_ref();
+		FieldIndex::from_bytes(cache, field, fs::read(path)?)
+			.ok_or_else(|| format!("'{}' is not a current index of {field}", path.display()).into())
+	}
+
+	/// Write the index to disk.
+	pub fn save<P: AsRef<Path>>(&self, path: P) -> Result<(), AptErrors> {
+		// Write then rename so readers never see a partial index.
+		let path = path.as_ref();
+		let tmp = path.with_extension("tmp");
+		fs::write(&tmp, &self.data)?;
+		fs::rename(&tmp, path)?;
+		Ok(())
+	}
+
+	/// Where the index of `field` is kept by default, next to
+	/// `pkgcache.bin`.
+	pub fn default_path(field: &str) -> PathBuf {
+		let pkgcache = Config::new().file("Dir::Cache::pkgcache", "/var/cache/apt/pkgcache.bin");
+		PathBuf::from(format!("{pkgcache}.{}.idx", field.to_lowercase()))
+	}
+
+	/// All of the versions whose field is exactly `value`.
+	pub fn get(&self, value: &str) -> impl Iterator<Item = Version<'a>> + '_ {
+		let (start, len) = self.find(value.as_bytes()).unwrap_or((0, 0));
+		(start..start + len).map(move |slot| {
+			let index = self.u32_at(self.versions + slot * 4) as u64;
+			// Every version was checked against the cache in `from_bytes`.
+			Version::new(unsafe { self.cache.find_ver_by_index(index) }, self.cache)
+		})
+	}
+
+	/// Every distinct value of the field, in sorted order.
+	pub fn keys(&self) -> impl Iterator<Item = &str> {
+		(0..self.keys).filter_map(|n| std::str::from_utf8(self.key(n)).ok())
+	}
+
+	/// The number of distinct values of the field.
+	pub fn len(&self) -> usize { self.keys }
+
+	/// Returns [`true`] if no version has the field.
+	pub fn is_empty(&self) -> bool { self.keys == 0 }
+
+	/// Check the header against the cache and the file size.
+	fn from_bytes(cache: &'a Cache, field: &str, data: Vec<u8>) -> Option<FieldIndex<'a>> {
+		if data.len() < HEADER_SIZE || &data[..8] != MAGIC {
+			return None;
+		}
+
+		let read = |pos: usize| u32::from_le_bytes(data[pos..pos + 4].try_into().unwrap()) as usize;
+		let fingerprint = u64::from_le_bytes(data[8..16].try_into().unwrap());
+		let (keys, field_len) = (read(16), read(20));
+		let (table, versions, strings) = (read(24), read(28), read(32));
+
+		if fingerprint != cache.fingerprint()
+			|| data.get(HEADER_SIZE..HEADER_SIZE + field_len) != Some(field.as_bytes())
+			|| table + keys * ENTRY_SIZE > versions
+			|| versions > strings
+			|| strings > data.len()
+		{
+			return None;
+		}
+
+		let index = FieldIndex {
+			cache,
+			data,
+			keys,
+			table,
+			versions,
+			strings,
+		};
+
+		// Every entry must point inside the file.
+		let version_slots = (index.strings - index.versions) / 4;
+		let strings_len = index.data.len() - index.strings;
+		for n in 0..keys {
+			let entry = index.table + n * ENTRY_SIZE;
+			let (str_off, str_len) = (index.u32_at(entry), index.u32_at(entry + 4));
+			let (ver_off, ver_len) = (index.u32_at(entry + 8), index.u32_at(entry + 12));
+			if str_off + str_len > strings_len || ver_off + ver_len > version_slots {
+				return None;
+			}
+		}
+
+		// The versions are read back without any checks, so every one of them
+		// must be a version of this cache. A matching fingerprint only says
+		// the file was meant for it.
+		let mut valid = cache.version_indexes();
+		valid.sort_unstable();
+		for slot in 0..version_slots {
+			let ver = index.u32_at(index.versions + slot * 4) as u64;
+			if valid.binary_search(&ver).is_err() {
+				return None;
+			}
+		}
+		Some(index)
+	}
+
+	fn u32_at(&self, pos: usize) -> usize {
+		u32::from_le_bytes(self.data[pos..pos + 4].try_into().unwrap()) as usize
+	}
+
+	fn key(&self, n: usize) -> &[u8] {
+		let entry = self.table + n * ENTRY_SIZE;
+		let start = self.strings + self.u32_at(entry);
+		&self.data[start..start + self.u32_at(entry + 4)]
+	}
+
+	/// Binary search the keys, returning the slot and count of the versions.
+	fn find(&self, value: &[u8]) -> Option<(usize, usize)> {
+		let (mut low, mut high) = (0, self.keys);
+		while low < high {
+			let mid = (low + high) / 2;
+			match self.key(mid).cmp(value) {
+				std::cmp::Ordering::Less => low = mid + 1,
+				std::cmp::Ordering::Greater => high = mid,
+				std::cmp::Ordering::Equal => {
+					let entry = self.table + mid * ENTRY_SIZE;
+					return Some((self.u32_at(entry + 8), self.u32_at(entry + 12)));
+				},
+			}
+		}
+		None
+	}
+}
+
+/// Lay the index out as it is stored on disk.
+///
+/// BTreeMap keeps the keys in byte order, which is what `find` expects.
+fn encode(fingerprint: u64, field: &str, map: &BTreeMap<String, Vec<u32>>) -> Vec<u8> {
+	let table = HEADER_SIZE + field.len();
+	let versions = table + map.len() * ENTRY_SIZE;
+	let strings = versions + map.values().map(|v| v.len() * 4).sum::<usize>();
+
+	let mut data = Vec::with_capacity(strings + map.keys().map(|k| k.len()).sum::<usize>());
+	data.extend_from_slice(MAGIC);
+	data.extend_from_slice(&fingerprint.to_le_bytes());
+	for value in [map.len(), field.len(), table, versions, strings] {
+		data.extend_from_slice(&(value as u32).to_le_bytes());
+	}
+	data.extend_from_slice(field.as_bytes());
+
+	let (mut str_off, mut ver_off) = (0, 0);
+	for (key, vers) in map {
+		for value in [str_off, key.len(), ver_off, vers.len()] {
+			data.extend_from_slice(&(value as u32).to_le_bytes());
+		}
+		str_off += key.len();
+		ver_off += vers.len();
+	}
+
+	for index in map.values().flatten() {
+		data.extend_from_slice(&index.to_le_bytes());
+	}
+
+	for key in map.keys() {
+		data.extend_from_slice(key.as_bytes());
+	}
+	data
+}
@@ -4,7 +4,8 @@ use std::fmt;
 
 use cxx::UniquePtr;
 
-use crate::raw::{DepIterator, VerIterator};
+use crate::raw::{DepIterator, TargetIterator, VerIterator};
+use crate::util::non_empty;
 use crate::{Cache, Package, Version};
 
 /// DepFlags defined in depcache.h
@@ -19,7 +20,7 @@ pub mod DepFlags {
 }
 
 /// The different types of Dependencies.
-#[derive(Debug, Eq, PartialEq, Hash)]
+#[derive(Debug, Clone, Copy, Eq, PartialEq, Hash)]
 pub enum DepType {
 	Depends = 1,
 	PreDepends = 2,
@@ -112,7 +113,7 @@ impl<'a> BaseDep<'a> {
 					.version(),
 			)
 		} else {
-			self.target_ver().ok()
+			non_empty(self.target_ver_or_empty())
 		}
 	}
 
@@ -120,17 +121,44 @@ impl<'a> BaseDep<'a> {
 	pub fn dep_type(&self) -> DepType { DepType::from(self.ptr.dep_type()) }
 
 	/// Comparison type of the dependency version, if specified.
-	pub fn comp_type(&self) -> Option<&str> { self.ptr.comp_type().ok() }
+	pub fn comp_type(&self) -> Option<&str> { non_empty(self.ptr.comp_type_or_empty()) }
 
 	// Iterate all Versions that are able to satisfy this dependency
-	pub fn all_targets(&self) -> Vec<Version> {
-		unsafe {
-			self.ptr
-				.all_targets()
-				.iter()
-				.map(|v| Version::new(v.unique(), self.cache))
-				.collect()
+	pub fn all_targets(&self) -> Vec<Version<'a>> { self.targets().collect() }
+
+	/// Lazily iterate the Versions that are able to satisfy this dependency.
+	///
+	/// The versions are checked one at a time as the iterator is advanced,
+	/// so nothing is allocated for versions that are never looked at.
+	/// Use this over [`BaseDep::all_targets`] when only the first few, or
+	/// whether there are any at all, matter.
+	pub fn targets(&self) -> Targets<'a> {
+		Targets {
+			ptr: unsafe { self.ptr.targets() },
+			cache: self.cache,
+		}
+	}
+}
+
+/// Iterator over the Versions that satisfy a [`BaseDep`].
+///
+/// These are the versions of the target package, followed by the versions
+/// that provide it.
+pub struct Targets<'a> {
+	ptr: UniquePtr<TargetIterator>,
+	cache: &'a Cache,
+}
+
+impl<'a> Iterator for Targets<'a> {
+	type Item = Version<'a>;
+
+	fn next(&mut self) -> Option<Self::Item> {
+		if self.ptr.end() {
+			return None;
 		}
+		let ver = Version::new(unsafe { self.ptr.version() }, self.cache);
+		self.ptr.pin_mut().raw_next();
+		Some(ver)
 	}
 }
 
@@ -245,6 +273,7 @@ pub(crate) mod raw {
 		include!("rust-apt/apt-pkg-c/package.h");
 
 		type DepIterator;
+		type TargetIterator;
 
 		type PkgIterator = crate::raw::PkgIterator;
 		type VerIterator = crate::raw::VerIterator;
@@ -300,6 +329,11 @@ pub(crate) mod raw {
 
 		pub fn target_ver(self: &DepIterator) -> Result<&str>;
 
+		/// [`DepIterator::comp_type`] and [`DepIterator::target_ver`], but
+		/// an empty str instead of an error when they aren't specified.
+		pub fn comp_type_or_empty(self: &DepIterator) -> &str;
+		pub fn target_ver_or_empty(self: &DepIterator) -> &str;
+
 		/// Return the Target Package for the dependency.
 		///
 		/// # Safety
@@ -326,6 +360,36 @@ pub(crate) mod raw {
 		/// The returned UniquePtr cannot outlive the cache.
 		unsafe fn all_targets(self: &DepIterator) -> UniquePtr<CxxVector<VerIterator>>;
 
+		/// Returns an iterator over the Versions that satisfy the
+		/// dependency, checked one at a time.
+		///
+		/// # Safety
+		///
+		/// The returned UniquePtr cannot outlive the cache.
+		unsafe fn targets(self: &DepIterator) -> UniquePtr<TargetIterator>;
+
+		/// Advance to the next Version that satisfies the dependency.
+		pub fn raw_next(self: Pin<&mut TargetIterator>);
+
+		/// Returns true once every target has been visited.
+		pub fn end(self: &TargetIterator) -> bool;
+
+		/// The Version the iterator is on.
+		///
+		/// # Safety
+		///
+		/// The iterator must not be at the end.
+		///
+		/// The returned UniquePtr cannot outlive the cache.
+		unsafe fn version(self: &TargetIterator) -> UniquePtr<VerIterator>;
+
+		/// Clone the pointer.
+		///
+		/// # Safety
+		///
+		/// The returned UniquePtr cannot outlive the cache.
+		unsafe fn unique(self: &TargetIterator) -> UniquePtr<TargetIterator>;
+
 		/// Return true if this dep is Or'd with the next. The last dep in the
 		/// or group will return False.
 		pub fn or_dep(self: &DepIterator) -> bool;
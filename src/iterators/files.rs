@@ -21,6 +21,9 @@ impl<'a> VersionFile<'a> {
 	/// Return the PkgRecords Parser for the VersionFile
 	pub fn lookup(&self) -> &PackageRecords { self.cache.records().ver_lookup(&self.ptr) }
 
+	/// The position of the record on disk, as `(package file, offset)`.
+	pub fn position(&self) -> (u64, u64) { (self.ptr.file_index(), self.ptr.offset()) }
+
 	/// Return the PackageFile for this VersionFile
 	pub fn package_file(&self) -> PackageFile<'a> {
 		PackageFile::new(unsafe { self.ptr.package_file() }, self.cache)
@@ -52,7 +55,7 @@ impl<'a> PackageFile<'a> {
 	}
 }
 
-cxx_convert_result!(
+cxx_convert_empty!(
 	PackageFile,
 	/// The path to the PackageFile
 	filename() -> &str,
@@ -116,6 +119,18 @@ pub(crate) mod raw {
 		/// file,
 		pub fn index_type(self: &PkgFileIterator) -> Result<&str>;
 
+		// The same as above, but an empty str instead of an error when the
+		// field doesn't exist.
+		pub fn filename_or_empty(self: &PkgFileIterator) -> &str;
+		pub fn archive_or_empty(self: &PkgFileIterator) -> &str;
+		pub fn origin_or_empty(self: &PkgFileIterator) -> &str;
+		pub fn codename_or_empty(self: &PkgFileIterator) -> &str;
+		pub fn label_or_empty(self: &PkgFileIterator) -> &str;
+		pub fn site_or_empty(self: &PkgFileIterator) -> &str;
+		pub fn component_or_empty(self: &PkgFileIterator) -> &str;
+		pub fn arch_or_empty(self: &PkgFileIterator) -> &str;
+		pub fn index_type_or_empty(self: &PkgFileIterator) -> &str;
+
 		/// `true` if the PackageFile contains packages that can be downloaded
 		pub fn is_downloadable(self: &PkgFileIterator) -> bool;
 
@@ -148,6 +163,12 @@ pub(crate) mod raw {
 		/// The returned UniquePtr cannot outlive the cache.
 		unsafe fn package_file(self: &VerFileIterator) -> UniquePtr<PkgFileIterator>;
 
+		/// The index of the [`PkgFileIterator`] the record is in.
+		pub fn file_index(self: &VerFileIterator) -> u64;
+
+		/// The byte offset of the record within its package file.
+		pub fn offset(self: &VerFileIterator) -> u64;
+
 		#[cxx_name = "Index"]
 		pub fn index(self: &VerFileIterator) -> u64;
 		/// Clone the pointer.
@@ -4,7 +4,7 @@ pub mod package;
 pub mod provider;
 pub mod version;
 
-pub use dependency::raw::DepIterator;
+pub use dependency::raw::{DepIterator, TargetIterator};
 pub use files::raw::{DescIterator, PkgFileIterator, VerFileIterator};
 pub use package::raw::PkgIterator;
 pub use provider::raw::PrvIterator;
@@ -1,11 +1,11 @@
-use std::cell::OnceCell;
+use std::cell::{Cell, OnceCell};
 use std::collections::HashMap;
 use std::fmt;
 
 use cxx::UniquePtr;
 
 use crate::raw::{IntoRawIter, PkgIterator};
-use crate::{create_depends_map, Cache, DepType, Dependency, Provider, Version};
+use crate::{create_depends_map, Cache, DepType, Dependency, Provider, StateFlags, Version};
 /// The state that the user wishes the package to be in.
 #[derive(Debug, Eq, PartialEq, Hash)]
 pub enum PkgSelectedState {
@@ -84,6 +84,8 @@ pub struct Package<'a> {
 	pub(crate) ptr: UniquePtr<PkgIterator>,
 	pub(crate) cache: &'a Cache,
 	rdepends_map: OnceCell<HashMap<DepType, Vec<Dependency<'a>>>>,
+	/// The DepCache generation and the flags that were read at it.
+	state: Cell<Option<(u64, u32)>>,
 }
 
 impl<'a> Package<'a> {
@@ -92,6 +94,7 @@ impl<'a> Package<'a> {
 			ptr,
 			cache,
 			rdepends_map: OnceCell::new(),
+			state: Cell::new(None),
 		}
 	}
 
@@ -229,44 +232,67 @@ impl<'a> Package<'a> {
 	///
 	///   * [true] = Increases performance by skipping the pkgDepCache.
 	///   * [false] = Use DepCache to check if the package is upgradable
-	pub fn is_upgradable(&self) -> bool {
-		self.is_installed() && self.cache.depcache().is_upgradable(self)
-	}
+	pub fn is_upgradable(&self) -> bool { self.has_state(StateFlags::Upgradable) }
 
 	/// Check if the package is auto installed. (Not installed by the user)
-	pub fn is_auto_installed(&self) -> bool { self.cache.depcache().is_auto_installed(self) }
+	pub fn is_auto_installed(&self) -> bool { self.has_state(StateFlags::Auto) }
 
 	/// Check if the package is auto removable
 	pub fn is_auto_removable(&self) -> bool {
-		(self.is_installed() || self.marked_install()) && self.cache.depcache().is_garbage(self)
+		// Garbage is swept when an action group is released, which doesn't
+		// change the generation, so it is always looked up.
+		self.state_flags() & (StateFlags::Installed | StateFlags::NewInstall) != 0
+			&& self.cache.depcache().is_garbage(self)
 	}
 
 	/// Check if the package is now broken
-	pub fn is_now_broken(&self) -> bool { self.cache.depcache().is_now_broken(self) }
+	pub fn is_now_broken(&self) -> bool { self.has_state(StateFlags::NowBroken) }
 
 	/// Check if the package package installed is broken
-	pub fn is_inst_broken(&self) -> bool { self.cache.depcache().is_inst_broken(self) }
+	pub fn is_inst_broken(&self) -> bool { self.has_state(StateFlags::InstBroken) }
 
 	/// Check if the package is marked install
-	pub fn marked_install(&self) -> bool { self.cache.depcache().marked_install(self) }
+	pub fn marked_install(&self) -> bool { self.has_state(StateFlags::NewInstall) }
 
 	/// Check if the package is marked upgrade
-	pub fn marked_upgrade(&self) -> bool { self.cache.depcache().marked_upgrade(self) }
+	pub fn marked_upgrade(&self) -> bool { self.has_state(StateFlags::Upgrade) }
 
 	/// Check if the package is marked purge
-	pub fn marked_purge(&self) -> bool { self.cache.depcache().marked_purge(self) }
+	pub fn marked_purge(&self) -> bool { self.has_state(StateFlags::Purge) }
 
 	/// Check if the package is marked delete
-	pub fn marked_delete(&self) -> bool { self.cache.depcache().marked_delete(self) }
+	pub fn marked_delete(&self) -> bool { self.has_state(StateFlags::Delete) }
 
 	/// Check if the package is marked keep
-	pub fn marked_keep(&self) -> bool { self.cache.depcache().marked_keep(self) }
+	pub fn marked_keep(&self) -> bool { self.has_state(StateFlags::Keep) }
 
 	/// Check if the package is marked downgrade
-	pub fn marked_downgrade(&self) -> bool { self.cache.depcache().marked_downgrade(self) }
+	pub fn marked_downgrade(&self) -> bool { self.has_state(StateFlags::Downgrade) }
 
 	/// Check if the package is marked reinstall
-	pub fn marked_reinstall(&self) -> bool { self.cache.depcache().marked_reinstall(self) }
+	pub fn marked_reinstall(&self) -> bool { self.has_state(StateFlags::ReInstall) }
+
+	/// Every [`StateFlags`] of the package.
+	///
+	/// The flags are read from the DepCache once and kept until a mark,
+	/// resolve or upgrade changes it, so the `is_*` and `marked_*` checks of
+	/// one package only look up its state a single time. The Garbage flag is
+	/// not kept up to date, use [`Package::is_auto_removable`] for that.
+	pub fn state_flags(&self) -> u32 {
+		let depcache = self.cache.depcache();
+		let generation = depcache.generation();
+		if let Some((seen, flags)) = self.state.get() {
+			if seen == generation {
+				return flags;
+			}
+		}
+
+		let flags = depcache.state_flags(self);
+		self.state.set(Some((generation, flags)));
+		flags
+	}
+
+	fn has_state(&self, flag: u32) -> bool { self.state_flags() & flag != 0 }
 
 	/// # Mark a package as automatically installed.
 	///
@@ -386,6 +412,9 @@ pub(crate) mod raw {
 		/// Get the architecture of a package.
 		pub fn arch(self: &PkgIterator) -> &str;
 
+		/// The dense ID of the package, from 0 up to the number of packages.
+		pub fn id(self: &PkgIterator) -> u32;
+
 		/// Get the fullname of the package.
 		///
 		/// Pretty is a bool that will omit the native arch.
@@ -453,6 +482,14 @@ pub(crate) mod raw {
 
 		#[cxx_name = "Index"]
 		pub fn index(self: &PkgIterator) -> u64;
+
+		/// Move the iterator to the package at `index`.
+		///
+		/// # Safety
+		///
+		/// The index must come from the same cache, anything else can
+		/// segfault.
+		unsafe fn seek(self: Pin<&mut PkgIterator>, index: u64);
 		/// Clone the pointer.
 		///
 		/// # Safety
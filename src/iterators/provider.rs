@@ -67,6 +67,10 @@ pub(crate) mod raw {
 		/// The version string that this provides
 		pub fn version_str(self: &PrvIterator) -> Result<&str>;
 
+		/// The version string that this provides, or an empty str if the
+		/// provides isn't versioned.
+		pub fn version_str_or_empty(self: &PrvIterator) -> &str;
+
 		/// The Target Package that can satisfy this provides
 		///
 		/// # Safety
@@ -6,7 +6,7 @@ use std::fmt;
 use cxx::UniquePtr;
 
 use crate::raw::{IntoRawIter, VerIterator};
-use crate::util::cmp_versions;
+use crate::util::{cmp_versions, VersionKey};
 use crate::{
 	create_depends_map, Cache, DepType, Dependency, Package, PackageFile, PackageRecords, Provider,
 	VersionFile,
@@ -17,6 +17,7 @@ pub struct Version<'a> {
 	pub(crate) ptr: UniquePtr<VerIterator>,
 	cache: &'a Cache,
 	depends_map: OnceCell<HashMap<DepType, Vec<Dependency<'a>>>>,
+	sort_key: OnceCell<VersionKey>,
 }
 
 impl<'a> Version<'a> {
@@ -25,6 +26,7 @@ impl<'a> Version<'a> {
 			ptr,
 			cache,
 			depends_map: OnceCell::new(),
+			sort_key: OnceCell::new(),
 		}
 	}
 
@@ -153,6 +155,30 @@ impl<'a> Version<'a> {
 			.get_field(field.to_string())
 	}
 
+	/// Get several record fields at once from a single scan of the record.
+	///
+	/// To borrow the fields instead of copying them use a
+	/// [`crate::records::RecordReader`].
+	///
+	/// # Example:
+	/// ```
+	/// use rust_apt::new_cache;
+	/// use rust_apt::records::RecordField;
+	///
+	/// let cache = new_cache!().unwrap();
+	/// let cand = cache.get("apt").unwrap().candidate().unwrap();
+	///
+	/// let fields = cand
+	///     .get_records(&[RecordField::Maintainer, RecordField::Filename])
+	///     .unwrap();
+	///
+	/// println!("{:?} {:?}", fields[0], fields[1]);
+	/// ```
+	pub fn get_records(&self, fields: &[&str]) -> Option<Vec<Option<String>>> {
+		let file = self.version_files().next()?;
+		self.cache.records().ver_lookup(&file).get_fields(fields)
+	}
+
 	/// Get the hash specified. If there isn't one returns None
 	/// `version.hash("md5sum")`
 	pub fn hash<T: ToString + ?Sized>(&self, hash_type: &T) -> Option<String> {
@@ -181,6 +207,15 @@ impl<'a> Version<'a> {
 		})
 	}
 
+	/// The [`VersionKey`] of the version string, parsed on first use.
+	///
+	/// Comparing keys gives the same order as comparing the versions, without
+	/// parsing them again each time.
+	pub fn sort_key(&self) -> &VersionKey {
+		self.sort_key
+			.get_or_init(|| VersionKey::new(self.version()))
+	}
+
 	/// Set this version as the candidate.
 	pub fn set_candidate(&self) { self.cache.depcache().set_candidate_version(self); }
 
@@ -260,6 +295,11 @@ pub(crate) mod raw {
 		/// The priority string as shown in `apt show`.
 		pub fn priority_str(self: &VerIterator) -> Result<&str>;
 
+		/// [`VerIterator::section`] and [`VerIterator::priority_str`], but an
+		/// empty str instead of an error when the version doesn't have one.
+		pub fn section_or_empty(self: &VerIterator) -> &str;
+		pub fn priority_str_or_empty(self: &VerIterator) -> &str;
+
 		/// The size of the .deb file.
 		pub fn size(self: &VerIterator) -> u64;
 
@@ -15,20 +15,28 @@
 #[macro_use]
 mod macros;
 mod acquire;
+pub mod archives;
 pub mod cache;
 pub mod config;
 mod depcache;
 pub mod error;
+pub mod graph;
+pub mod index;
 mod iterators;
+pub mod parallel;
 mod pkgmanager;
 pub mod progress;
 pub mod records;
+pub mod stats;
 pub mod tagfile;
 pub mod util;
 
 #[doc(inline)]
 pub use cache::{Cache, PackageSort};
-pub use iterators::dependency::{create_depends_map, BaseDep, DepFlags, DepType, Dependency};
+pub use depcache::{Checkpoint, DepCacheFork, Mark, StateFlags};
+pub use iterators::dependency::{
+	create_depends_map, BaseDep, DepFlags, DepType, Dependency, Targets,
+};
 pub use iterators::files::{PackageFile, VersionFile};
 pub use iterators::package::{Package, PkgCurrentState, PkgInstState, PkgSelectedState};
 pub use iterators::provider::Provider;
@@ -40,16 +48,17 @@ pub mod raw {
 		acquire_status, create_acquire, AcqTextStatus, AcqWorker, Item, ItemDesc, ItemState,
 		PkgAcquire,
 	};
-	pub use crate::cache::raw::{create_cache, PkgCacheFile};
-	pub use crate::depcache::raw::{ActionGroup, PkgDepCache};
+	pub use crate::cache::raw::{create_cache, create_cache_fast, PkgCacheFile, VersionIndex};
+	pub use crate::depcache::raw::{ActionGroup, DepCacheCheckpoint, PkgDepCache};
 	pub use crate::iterators::{
-		DepIterator, DescIterator, PkgFileIterator, PkgIterator, PrvIterator, VerFileIterator,
-		VerIterator,
+		DepIterator, DescIterator, PkgFileIterator, PkgIterator, PrvIterator, TargetIterator,
+		VerFileIterator, VerIterator,
 	};
 	pub use crate::pkgmanager::raw::{
 		create_pkgmanager, create_problem_resolver, PackageManager, ProblemResolver,
 	};
 	pub use crate::records::raw::{IndexFile, Parser, PkgRecords};
+	pub use crate::tagfile::raw::{open_tagfile, TagFile, TagSection};
 	pub use crate::util::raw::*;
 	// Hmm, maybe this is reason enough to make a wrapper in C++
 	// So that the raw functions are methods on a "Config" struct?
@@ -61,8 +70,12 @@ pub mod raw {
 	/// Iterator trait for libapt raw bindings
 	pub trait IntoRawIter {
 		type Item;
+		type Cursor;
 		fn raw_iter(self) -> Self::Item;
 
+		/// Step the pointer in place instead of cloning every element.
+		fn raw_cursor(self) -> Self::Cursor;
+
 		fn make_safe(self) -> Option<Self>
 		where
 			Self: Sized;
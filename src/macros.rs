@@ -57,11 +57,52 @@ macro_rules! raw_iter {
 				}
 			}
 
+			#[doc = "Cursor Struct for [`" $ty "`]."]
+			///
+			/// The cursor steps a single pointer in place and lends out a
+			/// reference to the current element instead of cloning it,
+			/// so walking the list costs no allocation per element.
+			pub struct [<Cursor $ty>] {
+				ptr: UniquePtr<$ty>,
+				started: bool,
+			}
+
+			impl [<Cursor $ty>] {
+				/// Advance the cursor and return the current element.
+				///
+				/// The reference is only valid until the next call.
+				#[allow(clippy::should_implement_trait)]
+				pub fn next(&mut self) -> Option<&$ty> {
+					if self.ptr.is_null() || self.ptr.end() {
+						return None;
+					}
+
+					if self.started {
+						self.ptr.pin_mut().raw_next();
+					}
+					self.started = true;
+
+					if self.ptr.end() {
+						None
+					} else {
+						Some(&*self.ptr)
+					}
+				}
+			}
+
 			impl IntoRawIter for UniquePtr<$ty> {
+				type Cursor = [<Cursor $ty>];
 				type Item = [<Iter $ty>];
 
 				fn raw_iter(self) -> Self::Item { [<Iter $ty>](self) }
 
+				fn raw_cursor(self) -> Self::Cursor {
+					[<Cursor $ty>] {
+						ptr: self,
+						started: false,
+					}
+				}
+
 				fn make_safe(self) -> Option<Self> { if self.end() { None } else { Some(self) } }
 
 				fn to_vec(self) -> Vec<Self> { self.raw_iter().collect() }
@@ -71,14 +112,17 @@ macro_rules! raw_iter {
 }
 
 /// Generates the boiler plate for wrapper structs
-/// where we need to change a Result to an option.
-macro_rules! cxx_convert_result {
+/// where we need to change an empty value to an option.
+///
+/// Each method calls the `_or_empty` variant of the raw method, which
+/// doesn't throw when the value is missing.
+macro_rules! cxx_convert_empty {
 	($wrapper:ident, $($(#[$meta:meta])* $method:ident ( $( $arg:ident : $arg_ty:ty ),* ) -> $ret:ty ),* $(,)? ) => {
 		impl<'a> $wrapper<'a> {
 			$(
 				$(#[$meta])*
 				pub fn $method(&self, $( $arg : $arg_ty ),* ) -> Option<$ret> {
-					self.ptr.$method($( $arg ),*).ok()
+					::paste::paste!($crate::util::non_empty(self.ptr.[<$method _or_empty>]($( $arg ),*)))
 				}
 			)*
 		}
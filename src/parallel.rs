@@ -0,0 +1,145 @@
+//! Split full cache scans between threads.
+//!
+//! The packages are handed out in small chunks from a shared counter, so a
+//! thread that finishes early takes more work instead of sitting idle.
+//! Results are always put back in the order of the cache.
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::thread;
+
+use crate::cache::CacheView;
+use crate::raw::PkgIterator;
+
+/// The number of packages a thread takes at a time.
+const CHUNK_SIZE: usize = 256;
+
+/// Parallel operations over every package of a [`CacheView`].
+///
+/// Closures are given the raw [`PkgIterator`], which is only valid for the
+/// duration of the call.
+///
+/// ```
+/// use rust_apt::{new_cache, StateFlags};
+///
+/// let mut cache = new_cache!().unwrap();
+/// let view = cache.view();
+///
+/// let installed = view.par_packages().map_reduce(
+///     || 0,
+///     |count, pkg| count + (view.state_flags(pkg) & StateFlags::Installed != 0) as usize,
+///     |a, b| a + b,
+/// );
+/// println!("{installed} packages are installed");
+/// ```
+pub struct ParPackages<'a> {
+	view: &'a CacheView<'a>,
+	indexes: Vec<u64>,
+	threads: usize,
+	chunk_size: usize,
+}
+
+impl<'a> ParPackages<'a> {
+	pub fn new(view: &'a CacheView<'a>) -> ParPackages<'a> {
+		ParPackages {
+			view,
+			indexes: view.package_indexes(),
+			threads: thread::available_parallelism().map_or(1, |n| n.get()),
+			chunk_size: CHUNK_SIZE,
+		}
+	}
+
+	/// Use this many threads. Defaults to the available parallelism.
+	pub fn threads(mut self, threads: usize) -> Self {
+		self.threads = threads.max(1);
+		self
+	}
+
+	/// Hand out this many packages at a time. Defaults to 256.
+	pub fn chunk_size(mut self, chunk_size: usize) -> Self {
+		self.chunk_size = chunk_size.max(1);
+		self
+	}
+
+	/// Call `f` on every package.
+	pub fn for_each<F>(self, f: F)
+	where
+		F: Fn(&PkgIterator) + Sync,
+	{
+		self.run(|| (), |_, pkg| f(pkg));
+	}
+
+	/// Keep the results of `f` that are [`Some`], in cache order.
+	pub fn filter_map<T, F>(self, f: F) -> Vec<T>
+	where
+		T: Send,
+		F: Fn(&PkgIterator) -> Option<T> + Sync,
+	{
+		self.run(Vec::new, |list, pkg| list.extend(f(pkg)))
+			.into_iter()
+			.flatten()
+			.collect()
+	}
+
+	/// Fold every package into a value with `map`, starting from `identity`,
+	/// and then combine the values of each chunk with `reduce`.
+	pub fn map_reduce<T, I, M, R>(self, identity: I, map: M, reduce: R) -> T
+	where
+		T: Send,
+		I: Fn() -> T + Sync,
+		M: Fn(T, &PkgIterator) -> T + Sync,
+		R: Fn(T, T) -> T,
+	{
+		self.run(
+			|| Some(identity()),
+			|acc, pkg| *acc = acc.take().map(|acc| map(acc, pkg)),
+		)
+		.into_iter()
+		.flatten()
+		.reduce(reduce)
+		.unwrap_or_else(identity)
+	}
+
+	/// Give each chunk its own value from `init` and step it with every
+	/// package in the chunk. The values are returned in chunk order.
+	fn run<T, I, S>(&self, init: I, step: S) -> Vec<T>
+	where
+		T: Send,
+		I: Fn() -> T + Sync,
+		S: Fn(&mut T, &PkgIterator) + Sync,
+	{
+		let chunks: Vec<&[u64]> = self.indexes.chunks(self.chunk_size).collect();
+		let next = AtomicUsize::new(0);
+
+		let mut done: Vec<(usize, T)> = thread::scope(|s| {
+			let workers: Vec<_> = (0..self.threads.min(chunks.len()))
+				.map(|_| {
+					s.spawn(|| {
+						let mut done = Vec::new();
+						// A single iterator per thread is moved to each package.
+						let mut pkg = unsafe { self.view.find_pkg_by_index(self.indexes[0]) };
+
+						loop {
+							let n = next.fetch_add(1, Ordering::Relaxed);
+							let Some(chunk) = chunks.get(n) else { break };
+
+							let mut acc = init();
+							for index in chunk.iter() {
+								unsafe { pkg.pin_mut().seek(*index) };
+								step(&mut acc, &pkg);
+							}
+							done.push((n, acc));
+						}
+						done
+					})
+				})
+				.collect();
+
+			workers
+				.into_iter()
+				.flat_map(|worker| worker.join().unwrap())
+				.collect()
+		});
+
+		done.sort_unstable_by_key(|(n, _)| *n);
+		done.into_iter().map(|(_, acc)| acc).collect()
+	}
+}
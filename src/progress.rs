@@ -1,7 +1,12 @@
 //! Contains Progress struct for updating the package list.
+use std::cell::RefCell;
 use std::fmt::Write as _;
 use std::io::{stdout, Write};
 use std::pin::Pin;
+use std::rc::Rc;
+use std::sync::atomic::{AtomicBool, AtomicU64, Ordering};
+use std::sync::Arc;
+use std::time::{Duration, Instant};
 
 use cxx::{ExternType, UniquePtr};
 
@@ -86,6 +91,13 @@ impl<'a> AcquireProgress<'a> {
 	/// Create a new AcquireProgress Struct that outputs nothing.
 	pub fn quiet() -> Self { Self::new(AptAcquireProgress::disable()) }
 
+	/// Create a new AcquireProgress Struct that only updates `counters`.
+	///
+	/// See [`CountingAcquireProgress`].
+	pub fn counting(counters: Arc<AcquireCounters>) -> Self {
+		Self::new(CountingAcquireProgress::new(counters))
+	}
+
 	/// Sets AcquireProgress as the AcqTextStatus callback and
 	/// returns a Pinned mutable reference to AcqTextStatus.
 	pub fn mut_status(&mut self) -> Pin<&mut AcqTextStatus> {
@@ -244,6 +256,229 @@ impl DynOperationProgress for NoOpProgress {
 	fn done(&mut self) {}
 }
 
+/// Progress of a download, kept in atomics by [`CountingAcquireProgress`].
+///
+/// Share it with an [`Arc`] and read it with [`AcquireCounters::snapshot`]
+/// from any thread, as often or as rarely as you like.
+#[derive(Debug, Default)]
+pub struct AcquireCounters {
+	hits: AtomicU64,
+	fetches: AtomicU64,
+	done: AtomicU64,
+	failed: AtomicU64,
+	workers: AtomicU64,
+	busy_workers: AtomicU64,
+	current_cps: AtomicU64,
+	fetched_bytes: AtomicU64,
+	current_bytes: AtomicU64,
+	total_bytes: AtomicU64,
+	percent: AtomicU64,
+	running: AtomicBool,
+}
+
+/// The values of [`AcquireCounters`] at one point.
+#[derive(Debug, Clone, Copy, Default, PartialEq)]
+pub struct AcquireSnapshot {
+	/// Items that were already up to date.
+	pub hits: u64,
+	/// Items that started downloading.
+	pub fetches: u64,
+	/// Items that finished downloading.
+	pub done: u64,
+	/// Items that were ignored or failed.
+	pub failed: u64,
+	/// Workers as of the last pulse.
+	pub workers: u64,
+	/// Workers with an item in progress as of the last pulse.
+	pub busy_workers: u64,
+	/// Bytes per second as of the last pulse.
+	pub current_cps: u64,
+	pub fetched_bytes: u64,
+	pub current_bytes: u64,
+	pub total_bytes: u64,
+	pub percent: f64,
+	/// [`true`] between the start and stop of the download.
+	pub running: bool,
+}
+
+impl AcquireCounters {
+	pub fn new() -> Arc<AcquireCounters> { Arc::default() }
+
+	/// Read every counter.
+	///
+	/// Each counter is read on its own, so values from the middle of a pulse
+	/// can be mixed with values from before it.
+	pub fn snapshot(&self) -> AcquireSnapshot {
+		let load = |counter: &AtomicU64| counter.load(Ordering::Relaxed);
+		AcquireSnapshot {
+			hits: load(&self.hits),
+			fetches: load(&self.fetches),
+			done: load(&self.done),
+			failed: load(&self.failed),
+			workers: load(&self.workers),
+			busy_workers: load(&self.busy_workers),
+			current_cps: load(&self.current_cps),
+			fetched_bytes: load(&self.fetched_bytes),
+			current_bytes: load(&self.current_bytes),
+			total_bytes: load(&self.total_bytes),
+			percent: f64::from_bits(load(&self.percent)),
+			running: self.running.load(Ordering::Relaxed),
+		}
+	}
+
+	fn bump(counter: &AtomicU64) { counter.fetch_add(1, Ordering::Relaxed); }
+
+	fn set(counter: &AtomicU64, value: u64) { counter.store(value, Ordering::Relaxed); }
+}
+
+/// An acquire progress that only updates [`AcquireCounters`].
+///
+/// No strings are copied and the workers are counted in place, so it
+/// costs next to nothing even with thousands of items.
+///
+/// ```
+/// use rust_apt::new_cache;
+/// use rust_apt::progress::{AcquireCounters, AcquireProgress};
+///
+/// let cache = new_cache!().unwrap();
+/// let counters = AcquireCounters::new();
+/// let mut progress = AcquireProgress::counting(counters.clone());
+///
+/// if cache.update(&mut progress).is_ok() {
+///     let stats = counters.snapshot();
+///     println!("{} hits, {} fetched", stats.hits, stats.done);
+/// }
+/// ```
+#[derive(Debug)]
+pub struct CountingAcquireProgress {
+	counters: Arc<AcquireCounters>,
+}
+
+impl CountingAcquireProgress {
+	pub fn new(counters: Arc<AcquireCounters>) -> Self { Self { counters } }
+
+	/// The counters this progress updates.
+	pub fn counters(&self) -> &Arc<AcquireCounters> { &self.counters }
+
+	fn update_status(&self, status: &AcqTextStatus) {
+		let counters = &self.counters;
+		AcquireCounters::set(&counters.current_cps, status.current_cps());
+		AcquireCounters::set(&counters.fetched_bytes, status.fetched_bytes());
+		AcquireCounters::set(&counters.current_bytes, status.current_bytes());
+		AcquireCounters::set(&counters.total_bytes, status.total_bytes());
+		AcquireCounters::set(&counters.percent, status.percent().to_bits());
+	}
+}
+
+impl DynAcquireProgress for CountingAcquireProgress {
+	/// Use the apt default.
+	fn pulse_interval(&self) -> usize { 0 }
+
+	fn hit(&mut self, _item: &ItemDesc) { AcquireCounters::bump(&self.counters.hits) }
+
+	fn fetch(&mut self, _item: &ItemDesc) { AcquireCounters::bump(&self.counters.fetches) }
+
+	fn fail(&mut self, _item: &ItemDesc) { AcquireCounters::bump(&self.counters.failed) }
+
+	fn pulse(&mut self, status: &AcqTextStatus, owner: &PkgAcquire) {
+		self.update_status(status);
+		AcquireCounters::set(&self.counters.workers, owner.worker_count() as u64);
+		AcquireCounters::set(&self.counters.busy_workers, owner.busy_workers() as u64);
+	}
+
+	fn done(&mut self, _item: &ItemDesc) { AcquireCounters::bump(&self.counters.done) }
+
+	fn start(&mut self) { self.counters.running.store(true, Ordering::Relaxed) }
+
+	fn stop(&mut self, status: &AcqTextStatus) {
+		self.update_status(status);
+		self.counters.running.store(false, Ordering::Relaxed);
+	}
+}
+
+/// The time spent in one operation that apt reported progress for.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct PhaseTime {
+	/// The operation as apt names it, such as "Calculating upgrade".
+	pub name: String,
+	pub elapsed: Duration,
+}
+
+/// The number of packages in each state of the DepCache.
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct MarkCounts {
+	pub install: u32,
+	pub delete: u32,
+	pub keep: u32,
+	pub broken: u32,
+}
+
+/// Timing and counters of an upgrade or resolve.
+///
+/// Returned by [`crate::Cache::upgrade_with_stats`] and
+/// [`crate::Cache::resolve_with_stats`]. Gathering them costs a clock read
+/// each time apt reports progress, so they can be left on.
+#[derive(Debug, Clone, Default)]
+pub struct OpStats {
+	/// Wall time of the whole call.
+	pub total: Duration,
+	/// Each operation apt reported progress for, in the order they ran.
+	pub phases: Vec<PhaseTime>,
+	/// The DepCache counts before the call.
+	pub before: MarkCounts,
+	/// The DepCache counts after the call.
+	pub after: MarkCounts,
+}
+
+impl OpStats {
+	/// The time spent outside of any operation apt reported.
+	pub fn unaccounted(&self) -> Duration {
+		let phases: Duration = self.phases.iter().map(|phase| phase.elapsed).sum();
+		self.total.saturating_sub(phases)
+	}
+}
+
+/// Times each operation for [`OpStats`].
+///
+/// A new phase starts whenever apt reports a different operation name.
+pub(crate) struct StatsProgress {
+	phases: Rc<RefCell<Vec<PhaseTime>>>,
+	current: Option<(String, Instant)>,
+}
+
+impl StatsProgress {
+	pub(crate) fn new(phases: Rc<RefCell<Vec<PhaseTime>>>) -> StatsProgress {
+		StatsProgress {
+			phases,
+			current: None,
+		}
+	}
+
+	fn finish(&mut self) {
+		if let Some((name, start)) = self.current.take() {
+			self.phases.borrow_mut().push(PhaseTime {
+				name,
+				elapsed: start.elapsed(),
+			});
+		}
+	}
+}
+
+impl DynOperationProgress for StatsProgress {
+	fn update(&mut self, operation: String, _percent: f32) {
+		if self.current.as_ref().map(|(name, _)| name) != Some(&operation) {
+			self.finish();
+			self.current = Some((operation, Instant::now()));
+		}
+	}
+
+	fn done(&mut self) { self.finish() }
+}
+
+impl Drop for StatsProgress {
+	fn drop(&mut self) { self.finish() }
+}
+
 /// AptAcquireProgress is the default struct for the update method on the cache.
 ///
 /// This struct mimics the output of `apt update`.
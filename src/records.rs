@@ -1,9 +1,13 @@
 //! Allows access to complete package description records directly from the
 //! file.
 use std::cell::{Ref, RefCell};
+use std::marker::PhantomData;
 
 use cxx::UniquePtr;
 
+use crate::util::non_empty;
+use crate::{Cache, Version, VersionFile};
+
 // TODO: Probably just make this a real enum
 // we an add a variant RecordField::String("Package".to_string())
 // or something like that.
@@ -173,22 +177,217 @@ impl PackageRecords {
 		self
 	}
 
-	pub fn short_desc(&self) -> Option<String> { self.parser().short_desc().ok() }
+	/// Look up the records of many versions in the order they are stored on
+	/// disk, calling `f` with the records moved to each version in turn.
+	///
+	/// Versions are visited by package file and then offset, which turns
+	/// a scan over many index files into mostly sequential reads. Versions
+	/// without a record are skipped.
+	///
+	/// ```
+	/// use rust_apt::new_cache;
+	/// use rust_apt::records::RecordField;
+	///
+	/// let cache = new_cache!().unwrap();
+	/// let versions: Vec<_> = cache.iter().filter_map(|pkg| pkg.candidate()).collect();
+	///
+	/// cache.records().for_each_sorted(&versions, |ver, records| {
+	///     println!("{} {:?}", ver, records.get_field(RecordField::Maintainer.into()));
+	/// });
+	/// ```
+	pub fn for_each_sorted<'a, F>(&self, versions: &[Version<'a>], mut f: F)
+	where
+		F: FnMut(&Version<'a>, &PackageRecords),
+	{
+		for (file, i) in sorted_files(versions) {
+			f(&versions[i], self.ver_lookup(&file));
+		}
+	}
+
+	pub fn short_desc(&self) -> Option<String> { non_empty(self.parser().short_desc_or_empty()) }
 
-	pub fn long_desc(&self) -> Option<String> { self.parser().long_desc().ok() }
+	pub fn long_desc(&self) -> Option<String> { non_empty(self.parser().long_desc_or_empty()) }
 
 	pub fn filename(&self) -> String { self.parser().filename() }
 
-	pub fn get_field(&self, field: String) -> Option<String> { self.parser().get_field(field).ok() }
+	pub fn get_field(&self, field: String) -> Option<String> {
+		non_empty(self.parser().get_field_or_empty(field))
+	}
+
+	/// Look up several fields of the record at once.
+	///
+	/// The record is scanned a single time for all of the fields, the
+	/// values are in the order they were requested. Use
+	/// [`RecordReader::get_fields`] to borrow them instead.
+	pub fn get_fields(&self, fields: &[&str]) -> Option<Vec<Option<String>>> {
+		let parser = self.parser();
+		let fields = RecordFields {
+			spans: parser.find_fields(fields).ok()?,
+			record: parser.record().ok()?,
+		};
+		let values = fields.iter().map(|value| value.map(str::to_string));
+		Some(values.collect())
+	}
 
 	pub fn hash_find(&self, hash_type: String) -> Option<String> {
-		self.parser().hash_find(hash_type).ok()
+		non_empty(self.parser().hash_find_or_empty(hash_type))
 	}
 }
 
+/// Records that lend out fields straight from the index files.
+///
+/// The reader is only moved to another record through `&mut self`, so the
+/// borrow checker makes sure no field outlives the record it was borrowed
+/// from. Each reader keeps its own place in the index files, get one from
+/// [`Cache::record_reader`].
+///
+/// ```
+/// use rust_apt::new_cache;
+/// use rust_apt::records::RecordField;
+///
+/// let cache = new_cache!().unwrap();
+/// let mut reader = cache.record_reader();
+///
+/// let cand = cache.get("apt").unwrap().candidate().unwrap();
+/// if reader.lookup(&cand) {
+///     println!("{:?}", reader.get_field(RecordField::Maintainer));
+/// }
+/// ```
+pub struct RecordReader<'a> {
+	ptr: UniquePtr<raw::PkgRecords>,
+	parser: UniquePtr<raw::Parser>,
+	index: Option<u64>,
+	cache: PhantomData<&'a Cache>,
+}
+
+// The parser points into the records, owning both here means they always
+// move to another thread together. Neither of them touches the depcache, they
+// only read the cache map which can't change while the reader borrows it.
+unsafe impl Send for RecordReader<'_> {}
+
+impl<'a> RecordReader<'a> {
+	pub(crate) fn new(ptr: UniquePtr<raw::PkgRecords>) -> RecordReader<'a> {
+		RecordReader {
+			ptr,
+			parser: UniquePtr::null(),
+			index: None,
+			cache: PhantomData,
+		}
+	}
+
+	/// Move the reader to the record of `ver`.
+	///
+	/// Returns [`false`] if the version doesn't have a record, the reader
+	/// then has no fields until the next lookup.
+	pub fn lookup(&mut self, ver: &Version) -> bool {
+		match ver.version_files().next() {
+			Some(file) => {
+				self.lookup_file(&file);
+				true
+			},
+			None => {
+				self.parser = UniquePtr::null();
+				self.index = None;
+				false
+			},
+		}
+	}
+
+	fn lookup_file(&mut self, file: &VersionFile) {
+		let index = file.ptr.index();
+		if self.index != Some(index) {
+			self.parser = unsafe { self.ptr.ver_lookup(&file.ptr) };
+			self.index = Some(index);
+		}
+	}
+
+	/// Visit the records of many versions in the order they are stored on
+	/// disk, see [`PackageRecords::for_each_sorted`].
+	pub fn for_each_sorted<F>(&mut self, versions: &[Version<'a>], mut f: F)
+	where
+		F: FnMut(&Version<'a>, &RecordReader<'a>),
+	{
+		for (file, i) in sorted_files(versions) {
+			self.lookup_file(&file);
+			f(&versions[i], self);
+		}
+	}
+
+	/// Borrow a field of the current record instead of copying it.
+	pub fn get_field(&self, field: &str) -> Option<&str> {
+		non_empty(self.parser.as_ref()?.get_field_ref_or_empty(field).ok()?)
+	}
+
+	/// Borrow several fields of the current record from a single scan of
+	/// it, see [`RecordFields`].
+	pub fn get_fields(&self, fields: &[&str]) -> Option<RecordFields> {
+		let parser = self.parser.as_ref()?;
+		Some(RecordFields {
+			spans: parser.find_fields(fields).ok()?,
+			record: parser.record().ok()?,
+		})
+	}
+
+	/// Borrow the whole current record.
+	pub fn record(&self) -> Option<&str> { self.parser.as_ref()?.record().ok() }
+}
+
+/// The first file of every version that has one, with the position of the
+/// version in `versions`, in the order they are stored on disk.
+fn sorted_files<'a>(versions: &[Version<'a>]) -> Vec<(VersionFile<'a>, usize)> {
+	let mut files: Vec<_> = versions
+		.iter()
+		.enumerate()
+		.filter_map(|(i, ver)| Some((ver.version_files().next()?, i)))
+		.collect();
+
+	files.sort_by_cached_key(|(file, _)| file.position());
+	files
+}
+
+/// Fields borrowed from a single record by [`RecordReader::get_fields`].
+///
+/// Field `n` is the `n`th name that was requested.
+pub struct RecordFields<'a> {
+	record: &'a str,
+	spans: Vec<raw::FieldSpan>,
+}
+
+impl<'a> RecordFields<'a> {
+	/// The value of the `n`th requested field, or None if the record
+	/// doesn't have it.
+	pub fn get(&self, n: usize) -> Option<&str> {
+		let span = self.spans.get(n)?;
+		if !span.found {
+			return None;
+		}
+		Some(&self.record[span.begin as usize..span.end as usize])
+	}
+
+	/// Iterate over the values in the order they were requested.
+	pub fn iter(&self) -> impl Iterator<Item = Option<&str>> {
+		(0..self.spans.len()).map(|n| self.get(n))
+	}
+
+	/// The number of fields that were requested.
+	pub fn len(&self) -> usize { self.spans.len() }
+
+	/// Returns [`true`] if no fields were requested.
+	pub fn is_empty(&self) -> bool { self.spans.is_empty() }
+}
+
 #[cxx::bridge]
 pub(crate) mod raw {
 	impl UniquePtr<IndexFile> {}
+
+	/// Where a requested field lies within [`Parser::record`].
+	struct FieldSpan {
+		/// [`false`] if the record doesn't have the field.
+		pub found: bool,
+		pub begin: u32,
+		pub end: u32,
+	}
+
 	unsafe extern "C++" {
 		include!("rust-apt/apt-pkg-c/records.h");
 		type PkgRecords;
@@ -223,8 +422,35 @@ pub(crate) mod raw {
 		pub fn long_desc(self: &Parser) -> Result<String>;
 		pub fn short_desc(self: &Parser) -> Result<String>;
 
+		/// [`Parser::long_desc`] and [`Parser::short_desc`], but an empty
+		/// String instead of an error when there isn't one.
+		pub fn long_desc_or_empty(self: &Parser) -> String;
+		pub fn short_desc_or_empty(self: &Parser) -> String;
+
 		pub fn get_field(self: &Parser, field: String) -> Result<String>;
+		/// Borrow the value of a field from the current record.
+		///
+		/// The returned str is only valid until the records are moved to
+		/// another file.
+		pub fn get_field_ref<'a>(self: &'a Parser, field: &str) -> Result<&'a str>;
+
+		/// [`Parser::get_field`] and [`Parser::get_field_ref`], but an empty
+		/// value instead of an error when the field doesn't exist.
+		///
+		/// `get_field_ref_or_empty` still returns an error if the record can't
+		/// be parsed at all.
+		pub fn get_field_or_empty(self: &Parser, field: String) -> String;
+		pub fn get_field_ref_or_empty<'a>(self: &'a Parser, field: &str) -> Result<&'a str>;
+
+		/// Borrow the whole current record.
+		pub fn record(self: &Parser) -> Result<&str>;
+
+		/// Locate each of the fields within [`Parser::record`] from a single
+		/// scan of the record.
+		pub fn find_fields(self: &Parser, fields: &[&str]) -> Result<Vec<FieldSpan>>;
 		pub fn hash_find(self: &Parser, hash_type: String) -> Result<String>;
+		/// [`Parser::hash_find`], but an empty String if there is no hash.
+		pub fn hash_find_or_empty(self: &Parser, hash_type: String) -> String;
 
 		pub fn archive_uri(self: &IndexFile, filename: &str) -> String;
 
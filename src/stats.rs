@@ -0,0 +1,117 @@
+//! Counters of what crosses into the C++ side.
+//!
+//! With the `instrument` feature every bridged call, every [`cxx::UniquePtr`]
+//! and String made for Rust, and every exception thrown back to it is counted
+//! under the name of the function or type. Without the feature the counters
+//! compile away and [`stats`] is always empty.
+//!
+//! ```
+//! use rust_apt::new_cache;
+//! use rust_apt::stats::{reset_stats, stats};
+//!
+//! let cache = new_cache!().unwrap();
+//! reset_stats();
+//!
+//! let installed = cache.iter().filter(|pkg| pkg.is_installed()).count();
+//!
+//! let stats = stats();
+//! println!("{installed} installed in {} calls", stats.total_calls());
+//! for (name, count) in stats.calls.iter().take(5) {
+//!     println!("{count:>8} {name}");
+//! }
+//! ```
+use std::collections::HashMap;
+
+/// A snapshot of the counters, each list sorted by count with the highest
+/// first.
+#[derive(Debug, Default, Clone)]
+pub struct Stats {
+	/// Calls into the bridge by function, such as `PkgIterator::name`.
+	pub calls: Vec<(String, u64)>,
+	/// Allocations by type, such as `VerIterator` or `String`.
+	pub allocations: Vec<(String, u64)>,
+	/// Exceptions by the bridged function that threw them, including those
+	/// thrown by the helpers it calls.
+	pub exceptions: Vec<(String, u64)>,
+}
+
+impl Stats {
+	/// Returns [`true`] if rust-apt was built with the `instrument` feature.
+	pub const fn enabled() -> bool { cfg!(feature = "instrument") }
+
+	/// The number of calls into the bridge.
+	pub fn total_calls(&self) -> u64 { total(&self.calls) }
+
+	/// The number of allocations made for Rust.
+	pub fn total_allocations(&self) -> u64 { total(&self.allocations) }
+
+	/// The number of exceptions thrown.
+	pub fn total_exceptions(&self) -> u64 { total(&self.exceptions) }
+}
+
+/// Take a snapshot of the counters.
+pub fn stats() -> Stats {
+	let mut kinds: [HashMap<String, u64>; 3] = Default::default();
+	for entry in raw::stats_snapshot() {
+		if entry.count == 0 {
+			continue;
+		}
+		if let Some(map) = kinds.get_mut(entry.kind as usize) {
+			*map.entry(clean_name(&entry.name)).or_default() += entry.count;
+		}
+	}
+
+	let [calls, allocations, exceptions] = kinds.map(|map| {
+		let mut list: Vec<(String, u64)> = map.into_iter().collect();
+		list.sort_unstable_by(|a, b| b.1.cmp(&a.1).then_with(|| a.0.cmp(&b.0)));
+		list
+	});
+
+	Stats {
+		calls,
+		allocations,
+		exceptions,
+	}
+}
+
+/// Set every counter back to zero.
+pub fn reset_stats() { raw::stats_reset() }
+
+fn total(list: &[(String, u64)]) -> u64 { list.iter().map(|(_, count)| count).sum() }
+
+/// Shorten what `__PRETTY_FUNCTION__` gives us.
+///
+/// `str PkgIterator::name() const` becomes `PkgIterator::name`, and the
+/// `[with T = VerIterator]` of `type_name` becomes `VerIterator`.
+fn clean_name(name: &str) -> String {
+	if let Some((_, ty)) = name.split_once("T = ") {
+		return ty.split([']', ';']).next().unwrap_or(ty).to_string();
+	}
+
+	let head = name.split('(').next().unwrap_or(name);
+	// The return type can have spaces of its own, the name never does.
+	head.rsplit([' ', '*', '&'])
+		.next()
+		.unwrap_or(head)
+		.to_string()
+}
+
+#[cxx::bridge]
+pub(crate) mod raw {
+	/// A single counter, `kind` is the `StatKind` from types.h.
+	struct StatEntry {
+		pub kind: u8,
+		pub name: String,
+		pub count: u64,
+	}
+
+	unsafe extern "C++" {
+		include!("rust-apt/apt-pkg-c/stats.h");
+
+		/// Every counter that has been reached.
+		pub fn stats_snapshot() -> Vec<StatEntry>;
+
+		/// Set every counter back to zero.
+		pub fn stats_reset();
+	}
+}
@@ -3,6 +3,10 @@ use core::iter::Iterator;
 use std::collections::HashMap;
 use std::fmt;
 
+use cxx::UniquePtr;
+
+use crate::error::AptErrors;
+
 #[derive(Debug)]
 /// The result of a parsing error.
 pub struct ParserError {
@@ -215,3 +219,413 @@ pub fn parse_tagfile(content: &str) -> Result<Vec<TagSection>, ParserError> {
 
 	Ok(sections)
 }
+
+/// A section borrowed from the text it was parsed from.
+///
+/// Unlike [`TagSection`] nothing is copied. A value that continues on the
+/// following lines is already laid out in the input the same way
+/// [`TagSection`] joins it, so every value is a slice of the section.
+#[derive(Debug, Clone)]
+pub struct TagSectionRef<'a> {
+	fields: Vec<(&'a str, &'a str)>,
+}
+
+impl<'a> TagSectionRef<'a> {
+	/// Parse a single section.
+	///
+	/// Values are the same as those of [`TagSection::new`], except that a key
+	/// with nothing after it has an empty value instead of `"\n"`.
+	pub fn new(section: &'a str) -> Result<Self, ParserError> {
+		if section.is_empty() {
+			return Err(error("An empty string was passed", None));
+		}
+
+		let mut fields = Vec::new();
+		// The key and the byte range of the value being parsed.
+		let mut current: Option<(&'a str, usize, usize)> = None;
+		let mut pos = 0;
+
+		for (index, line) in section.split('\n').enumerate() {
+			let start = pos;
+			pos += line.len() + 1;
+
+			if line.is_empty() {
+				// Only a trailing newline can leave an empty line.
+				if pos <= section.len() {
+					return Err(error("More than one section was found", Some(index + 1)));
+				}
+				continue;
+			}
+
+			// A continuation line extends the value up to its end.
+			if line.starts_with(' ') || line.starts_with('\t') {
+				match current.as_mut() {
+					Some((_, _, end)) => *end = start + line.len(),
+					None => {
+						return Err(error(
+							"No key defined for the currently indented line",
+							Some(index + 1),
+						));
+					},
+				}
+				continue;
+			}
+
+			// Anything else ends the current field.
+			if let Some((key, value_start, end)) = current.take() {
+				fields.push((key, &section[value_start..end]));
+			}
+
+			if line.starts_with('#') {
+				continue;
+			}
+
+			let Some(colon) = line.find(':') else {
+				return Err(error(
+					"Line doesn't contain a ':' separator",
+					Some(index + 1),
+				));
+			};
+
+			let value = &line[colon + 1..];
+			let value_start = start + colon + 1 + value.starts_with(' ') as usize;
+			current = Some((&line[..colon], value_start, start + line.len()));
+		}
+
+		if let Some((key, value_start, end)) = current {
+			fields.push((key, &section[value_start..end]));
+		}
+
+		Ok(Self { fields })
+	}
+
+	/// Get the value of the specified key.
+	///
+	/// Sections only have a handful of fields, so this is a linear search.
+	pub fn get(&self, key: &str) -> Option<&'a str> {
+		self.fields
+			.iter()
+			.find(|(field, _)| *field == key)
+			.map(|(_, value)| *value)
+	}
+
+	/// Get the value of the specified key,
+	///
+	/// Returns specified default on failure.
+	pub fn get_default(&self, key: &str, default: &'a str) -> &'a str {
+		self.get(key).unwrap_or(default)
+	}
+
+	/// The keys and values in the order they appear in the section.
+	pub fn iter(&self) -> impl Iterator<Item = (&'a str, &'a str)> + '_ {
+		self.fields.iter().copied()
+	}
+
+	/// The number of fields in the section.
+	pub fn len(&self) -> usize { self.fields.len() }
+
+	/// Returns [`true`] if the section has no fields.
+	pub fn is_empty(&self) -> bool { self.fields.is_empty() }
+
+	/// Copy the section into a [`TagSection`].
+	pub fn to_tag_section(&self) -> TagSection {
+		TagSection {
+			data: self
+				.iter()
+				.map(|(key, value)| (key.to_string(), value.to_string()))
+				.collect(),
+		}
+	}
+}
+
+fn error(msg: &str, line: Option<usize>) -> ParserError {
+	ParserError {
+		msg: "E:".to_owned() + msg,
+		line,
+	}
+}
+
+/// Iterate over the sections of a whole TagFile, such as a memory mapped
+/// `Packages` file, without copying any of it.
+///
+/// Any number of blank lines may separate the sections. Errors have the line
+/// number in the whole file.
+///
+/// ```
+/// use rust_apt::tagfile;
+///
+/// let content = "Package: one\nVersion: 1.0\n\nPackage: two\nVersion: 2.0\n";
+/// for section in tagfile::sections(content) {
+///     println!("{}", section.unwrap().get("Package").unwrap());
+/// }
+/// ```
+pub fn sections(content: &str) -> Sections<'_> {
+	Sections {
+		rest: content,
+		line: 0,
+	}
+}
+
+/// The iterator returned by [`sections`].
+pub struct Sections<'a> {
+	rest: &'a str,
+	/// The number of lines before `rest`.
+	line: usize,
+}
+
+impl<'a> Iterator for Sections<'a> {
+	type Item = Result<TagSectionRef<'a>, ParserError>;
+
+	fn next(&mut self) -> Option<Self::Item> {
+		let blank = self.rest.len() - self.rest.trim_start_matches('\n').len();
+		self.line += blank;
+		self.rest = &self.rest[blank..];
+		if self.rest.is_empty() {
+			return None;
+		}
+
+		let end = find_section_end(self.rest.as_bytes()).unwrap_or(self.rest.len());
+		let (section, rest) = self.rest.split_at(end);
+		let first_line = self.line;
+		self.rest = rest;
+		self.line += count_newlines(section.as_bytes());
+
+		Some(TagSectionRef::new(section).map_err(|mut err| {
+			err.line = Some(first_line + err.line.unwrap_or(1));
+			err
+		}))
+	}
+}
+
+/// Read a TagFile one section at a time.
+///
+/// Only the section being parsed is held in memory, in a buffer that is
+/// reused for every section, so files of any size are read in constant
+/// memory.
+///
+/// ```
+/// use std::fs::File;
+/// use std::io::BufReader;
+///
+/// use rust_apt::tagfile::TagFileReader;
+///
+/// let file = File::open("/var/lib/dpkg/status").unwrap();
+/// let mut reader = TagFileReader::new(BufReader::new(file));
+///
+/// while let Some(section) = reader.next_section() {
+///     println!("{}", section.unwrap().get_default("Package", "unknown"));
+/// }
+/// ```
+pub struct TagFileReader<R> {
+	reader: R,
+	buffer: String,
+	/// The number of lines already read.
+	line: usize,
+}
+
+impl<R: std::io::BufRead> TagFileReader<R> {
+	pub fn new(reader: R) -> TagFileReader<R> {
+		TagFileReader {
+			reader,
+			buffer: String::new(),
+			line: 0,
+		}
+	}
+
+	/// Read and parse the next section.
+	///
+	/// The section borrows the buffer of the reader, so it has to be dropped
+	/// before reading the next one. Use [`TagSectionRef::to_tag_section`] to
+	/// keep it.
+	pub fn next_section(&mut self) -> Option<Result<TagSectionRef<'_>, ParserError>> {
+		self.buffer.clear();
+		let mut first_line = self.line;
+
+		loop {
+			let start = self.buffer.len();
+			match self.reader.read_line(&mut self.buffer) {
+				Ok(0) => break,
+				Ok(_) => self.line += 1,
+				Err(err) => return Some(Err(error(&err.to_string(), Some(self.line + 1)))),
+			}
+
+			if &self.buffer[start..] == "\n" {
+				self.buffer.truncate(start);
+				if start != 0 {
+					break;
+				}
+				// Skip the blank lines before a section.
+				first_line = self.line;
+			}
+		}
+
+		if self.buffer.is_empty() {
+			return None;
+		}
+
+		Some(TagSectionRef::new(&self.buffer).map_err(|mut err| {
+			err.line = Some(first_line + err.line.unwrap_or(1));
+			err
+		}))
+	}
+}
+
+/// Find the `\n\n` that ends the first section of `bytes`.
+///
+/// This is where most of the time of [`sections`] goes. Newlines are
+/// searched for a word at a time, and only a newline followed by another
+/// one ends the section.
+fn find_section_end(bytes: &[u8]) -> Option<usize> {
+	let mut pos = 0;
+	while let Some(found) = find_newline(&bytes[pos..]) {
+		let newline = pos + found;
+		if bytes.get(newline + 1) == Some(&b'\n') {
+			return Some(newline);
+		}
+		pos = newline + 1;
+	}
+	None
+}
+
+const LO: u64 = u64::from_ne_bytes([0x01; 8]);
+const HI: u64 = u64::from_ne_bytes([0x80; 8]);
+const NEWLINES: u64 = u64::from_ne_bytes([b'\n'; 8]);
+
+/// Returns [`true`] if any byte of `word` is a newline.
+fn has_newline(word: u64) -> bool {
+	let x = word ^ NEWLINES;
+	x.wrapping_sub(LO) & !x & HI != 0
+}
+
+/// The position of the first newline in `bytes`, checking eight bytes at a
+/// time.
+fn find_newline(bytes: &[u8]) -> Option<usize> {
+	let mut chunks = bytes.chunks_exact(8);
+	let mut pos = 0;
+	for chunk in &mut chunks {
+		if has_newline(u64::from_ne_bytes(chunk.try_into().unwrap())) {
+			break;
+		}
+		pos += 8;
+	}
+	bytes[pos..]
+		.iter()
+		.position(|b| *b == b'\n')
+		.map(|found| pos + found)
+}
+
+fn count_newlines(bytes: &[u8]) -> usize { bytes.iter().filter(|b| **b == b'\n').count() }
+
+/// A TagFile read by apt's own parser.
+///
+/// Compressed files are decompressed based on their extension, the same way
+/// apt reads its lists, and field lookups use the index apt builds while
+/// scanning each section.
+///
+/// ```
+/// use rust_apt::tagfile::AptTagFile;
+///
+/// let mut file = AptTagFile::open("/var/lib/dpkg/status").unwrap();
+/// while let Some(section) = file.next_section().unwrap() {
+///     println!("{}", section.get("Package").unwrap_or("unknown"));
+/// }
+/// ```
+pub struct AptTagFile {
+	ptr: UniquePtr<raw::TagFile>,
+}
+
+impl AptTagFile {
+	/// Open the file at `path`.
+	pub fn open(path: &str) -> Result<AptTagFile, AptErrors> {
+		Ok(AptTagFile {
+			ptr: raw::open_tagfile(path)?,
+		})
+	}
+
+	/// Move to the next section, returning [`None`] at the end of the file.
+	///
+	/// The section borrows the buffer of the file, so it has to be dropped
+	/// before moving to the next one.
+	pub fn next_section(&mut self) -> Result<Option<AptTagSection<'_>>, AptErrors> {
+		if !self.ptr.pin_mut().step()? {
+			return Ok(None);
+		}
+		Ok(Some(AptTagSection {
+			ptr: self.ptr.section(),
+		}))
+	}
+
+	/// The offset of the current section in the uncompressed file.
+	pub fn offset(&mut self) -> u64 { self.ptr.pin_mut().offset() }
+}
+
+/// A section of an [`AptTagFile`].
+pub struct AptTagSection<'a> {
+	ptr: &'a raw::TagSection,
+}
+
+impl<'a> AptTagSection<'a> {
+	/// Get the value of the specified key.
+	pub fn get(&self, key: &str) -> Option<&'a str> {
+		let value = self.ptr.find_or_empty(key);
+		// Only an empty value needs a second look to tell a missing key apart.
+		if value.is_empty() && !self.exists(key) {
+			return None;
+		}
+		Some(value)
+	}
+
+	/// Returns [`true`] if the section has the key.
+	pub fn exists(&self, key: &str) -> bool { self.ptr.exists(key) }
+
+	/// The number of fields in the section.
+	pub fn len(&self) -> usize { self.ptr.count() as usize }
+
+	/// Returns [`true`] if the section has no fields.
+	pub fn is_empty(&self) -> bool { self.len() == 0 }
+
+	/// The whole text of the section.
+	pub fn text(&self) -> &'a str { self.ptr.text() }
+
+	/// Parse the text of the section into a [`TagSectionRef`], to walk its
+	/// fields in order.
+	pub fn to_section_ref(&self) -> Result<TagSectionRef<'a>, ParserError> {
+		TagSectionRef::new(self.text())
+	}
+}
+
+#[cxx::bridge]
+pub(crate) mod raw {
+	unsafe extern "C++" {
+		include!("rust-apt/apt-pkg-c/tagfile.h");
+		type TagFile;
+		type TagSection;
+
+		/// Open a TagFile, decompressing it based on its extension.
+		pub fn open_tagfile(path: &str) -> Result<UniquePtr<TagFile>>;
+
+		/// Move to the next section, returns false at the end of the file.
+		///
+		/// The previous section is no longer valid after this.
+		pub fn step(self: Pin<&mut TagFile>) -> Result<bool>;
+
+		/// The section the file was last stepped to.
+		pub fn section(self: &TagFile) -> &TagSection;
+
+		/// The offset in the uncompressed file of the current section.
+		pub fn offset(self: Pin<&mut TagFile>) -> u64;
+
+		/// Look up a field through apt's index of the section.
+		///
+		/// Returns an empty str instead of an error when the field doesn't
+		/// exist, so a miss never unwinds.
+		pub fn find_or_empty<'a>(self: &'a TagSection, field: &str) -> &'a str;
+		pub fn exists(self: &TagSection, field: &str) -> bool;
+
+		/// The number of fields in the section.
+		pub fn count(self: &TagSection) -> u32;
+
+		/// Borrow the whole text of the section.
+		pub fn text(self: &TagSection) -> &str;
+	}
+}
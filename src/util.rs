@@ -53,6 +53,127 @@ pub fn cmp_versions(ver1: &str, ver2: &str) -> Ordering {
 	}
 }
 
+/// A version string parsed once into bytes that sort the same way
+/// [`cmp_versions`] does.
+///
+/// Comparing two keys is a plain byte compare, so sorting many versions or
+/// comparing them all against one only parses each string once.
+///
+/// ```
+/// use rust_apt::util::VersionKey;
+///
+/// let mut versions = vec!["1:1.0", "1.0~rc1", "1.0", "1.0-1", "1.0+b1"];
+/// versions.sort_by_cached_key(|ver| VersionKey::new(ver));
+/// assert_eq!(versions, ["1.0~rc1", "1.0", "1.0-1", "1.0+b1", "1:1.0"]);
+/// ```
+#[derive(Debug, Clone, PartialEq, Eq, PartialOrd, Ord, Hash)]
+pub struct VersionKey(Box<[u8]>);
+
+impl VersionKey {
+	/// Split `version` into its epoch, upstream version and revision, and
+	/// encode each of them.
+	pub fn new(version: &str) -> VersionKey {
+		let version = version.as_bytes();
+		// Like apt, a leading colon does not start an epoch, and zeros are
+		// stripped from the epoch so `0:` is the same as none.
+		let (epoch, rest) = match version.iter().position(|c| *c == b':') {
+			Some(pos) if pos > 0 => (&version[..pos], &version[pos + 1..]),
+			_ => (&b""[..], version),
+		};
+		let epoch = &epoch[epoch.iter().position(|c| *c != b'0').unwrap_or(epoch.len())..];
+		// No revision compares the same as a revision of 0.
+		let (upstream, revision) = match rest.iter().rposition(|c| *c == b'-') {
+			Some(pos) => (&rest[..pos], &rest[pos + 1..]),
+			None => (rest, &b"0"[..]),
+		};
+
+		let mut key = Vec::with_capacity(version.len() * 2 + 24);
+		for part in [epoch, upstream, revision] {
+			encode_version_part(part, &mut key);
+		}
+		VersionKey(key.into_boxed_slice())
+	}
+
+	/// The encoded key.
+	pub fn as_bytes(&self) -> &[u8] { &self.0 }
+}
+
+/// The weight of each character outside of a number, as two big endian
+/// bytes. `~` sorts before the end of the run, which sorts before letters,
+/// which sort before everything else.
+fn char_weight(c: u8) -> u16 {
+	match c {
+		b'~' => 1,
+		_ if c.is_ascii_alphabetic() => c as u16 + 3,
+		_ => 0x100 + c as u16 + 3,
+	}
+}
+
+/// The weight that ends a run of characters, and the part itself.
+const RUN_END: u16 = 2;
+
+/// An empty part sorts after one starting with `~`, but before anything
+/// else.
+const EMPTY_PART: [u8; 4] = [0, 1, 0xFF, 0xFF];
+
+/// Encode one part of a version the way dpkg compares it, alternating
+/// runs of non digits and numbers.
+///
+/// Each character of a run is its weight, followed by [`RUN_END`]. Numbers
+/// are stripped of leading zeros and written as their length followed by
+/// the digits, so longer numbers sort higher. A part that isn't empty has at
+/// least one run and number, and ends with [`RUN_END`] which compares the same
+/// as running out of characters.
+fn encode_version_part(mut part: &[u8], key: &mut Vec<u8>) {
+	if part.is_empty() {
+		key.extend_from_slice(&EMPTY_PART);
+		return;
+	}
+
+	loop {
+		let run = part
+			.iter()
+			.position(u8::is_ascii_digit)
+			.unwrap_or(part.len());
+		for c in &part[..run] {
+			key.extend_from_slice(&char_weight(*c).to_be_bytes());
+		}
+		key.extend_from_slice(&RUN_END.to_be_bytes());
+		part = &part[run..];
+
+		let digits = part
+			.iter()
+			.position(|c| !c.is_ascii_digit())
+			.unwrap_or(part.len());
+		let number = &part[..digits];
+		let number = &number[number.iter().position(|c| *c != b'0').unwrap_or(digits)..];
+		key.extend_from_slice(&(number.len().min(u16::MAX as usize) as u16).to_be_bytes());
+		key.extend_from_slice(number);
+		part = &part[digits..];
+
+		if part.is_empty() {
+			break;
+		}
+	}
+	key.extend_from_slice(&RUN_END.to_be_bytes());
+}
+
+/// Sort `list` by the version each item has, parsing every version once.
+///
+/// ```
+/// use rust_apt::util::sort_by_version;
+///
+/// let mut list = vec![("apt", "2.6.1"), ("apt", "2.6.0"), ("apt", "2.10")];
+/// sort_by_version(&mut list, |(_, ver)| *ver);
+/// assert_eq!(list, [("apt", "2.6.0"), ("apt", "2.6.1"), ("apt", "2.10")]);
+/// ```
+pub fn sort_by_version<T, F>(list: &mut [T], mut version: F)
+where
+	F: FnMut(&T) -> &str,
+{
+	list.sort_by_cached_key(|item| VersionKey::new(version(item)));
+}
+
 /// Disk Space that `apt` will use for a transaction.
 pub enum DiskSpace {
 	/// Additional Disk Space required.
@@ -251,7 +372,10 @@ pub fn show_broken_pkg(cache: &Cache, pkg: &Package, now: bool) -> Option<String
 
 			broken_string += base_dep.target_package().name();
 
-			if let (Ok(ver_str), Some(comp)) = (base_dep.target_ver(), base_dep.comp_type()) {
+			if let (Some(ver_str), Some(comp)) = (
+				non_empty(base_dep.target_ver_or_empty()),
+				base_dep.comp_type(),
+			) {
 				broken_string += &format!(" ({comp} {ver_str})");
 			}
 
@@ -277,6 +401,12 @@ pub fn show_broken_pkg(cache: &Cache, pkg: &Package, now: bool) -> Option<String
 	Some(broken_string)
 }
 
+/// Turn the empty value returned by the `_or_empty` raw methods into
+/// [`None`].
+pub(crate) fn non_empty<T: AsRef<str>>(value: T) -> Option<T> {
+	(!value.as_ref().is_empty()).then_some(value)
+}
+
 #[cxx::bridge]
 pub(crate) mod raw {
 	unsafe extern "C++" {
@@ -295,6 +425,9 @@ pub(crate) mod raw {
 		/// Return an APT-styled progress bar (`[####..]`).
 		pub fn get_apt_progress_string(percent: f32, output_width: u32) -> String;
 
+		/// The SHA256 of the file at `path` in lowercase hex.
+		pub fn file_sha256(path: &str) -> Result<String>;
+
 		/// Lock the lockfile.
 		pub fn apt_lock() -> Result<()>;
 
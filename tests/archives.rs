@@ -0,0 +1,65 @@
+mod archives {
+	use rust_apt::archives::{archive_filename, ArchiveStore};
+	use rust_apt::new_cache;
+
+	#[test]
+	fn filename() {
+		let cache = new_cache!().unwrap();
+		let ver = cache.get("apt").unwrap().candidate().unwrap();
+
+		let name = archive_filename(&ver).unwrap();
+		assert!(name.starts_with("apt_"));
+		assert!(name.ends_with(&format!("_{}.deb", ver.arch())));
+		// Epochs are quoted.
+		assert!(!name.contains(':'));
+	}
+
+	#[test]
+	fn store() {
+		let cache = new_cache!().unwrap();
+		let store = ArchiveStore::new(std::env::temp_dir().join("rust-apt-test-archives")).unwrap();
+
+		assert!(!store.contains("0000"));
+		// Nothing is marked, so nothing is linked in either direction.
+		assert_eq!(store.link_into(&cache).unwrap(), 0);
+		assert_eq!(store.store_from(&cache).unwrap(), 0);
+	}
+
+	#[test]
+	fn store_and_link() {
+		let dir = std::env::temp_dir().join("rust-apt-test-archive-files");
+		let _ = std::fs::remove_dir_all(&dir);
+		let store = ArchiveStore::new(dir.join("store")).unwrap();
+
+		let sha256 = "5221e86a80b385eb4a5993e5e4fbe3b9218582f2ff401867c0ff8d60118848e4";
+		let src = dir.join("rust-apt_1.0_all.deb");
+		std::fs::write(&src, "rust-apt archive\n").unwrap();
+
+		// An archive that doesn't match its hash is left out.
+		let bad = dir.join("bad_1.0_all.deb");
+		std::fs::write(&bad, "not it\n").unwrap();
+		assert!(!store.insert(sha256, &bad).unwrap());
+		assert!(!store.contains(sha256));
+
+		// Uppercase hashes name the same archive.
+		assert!(store.insert(&sha256.to_uppercase(), &src).unwrap());
+		assert!(store.contains(sha256));
+		assert!(!store.insert(sha256, &src).unwrap());
+
+		let dest = dir.join("linked_1.0_all.deb");
+		assert!(store.link(sha256, &dest).unwrap());
+		assert_eq!(std::fs::read(&dest).unwrap(), b"rust-apt archive\n");
+		// Nothing is linked over a file that is already there.
+		assert!(!store.link(sha256, &dest).unwrap());
+
+		// An archive that went bad in the store is dropped instead of linked.
+		std::fs::remove_file(&dest).unwrap();
+		std::fs::remove_file(store.path(sha256)).unwrap();
+		std::fs::copy(&bad, store.path(sha256)).unwrap();
+		assert!(!store.link(sha256, &dest).unwrap());
+		assert!(!store.contains(sha256));
+		assert!(!dest.exists());
+
+		std::fs::remove_dir_all(dir).unwrap();
+	}
+}
@@ -1,12 +1,14 @@
 mod cache {
 	use std::collections::HashMap;
 	use std::fmt::Write as _;
+	use std::time::Duration;
 
 	use cxx::{CxxVector, UniquePtr};
 	use rust_apt::cache::*;
+	use rust_apt::graph::{DepFilter, Direction};
 	use rust_apt::raw::{create_acquire, IntoRawIter, ItemDesc};
 	use rust_apt::util::*;
-	use rust_apt::{new_cache, DepType};
+	use rust_apt::{new_cache, DepType, StateFlags};
 
 	// This is a manual test. I don't know a good way to dynamically test this
 	// Maybe by installing a test-deb with certain depends and checking the
@@ -46,6 +48,182 @@ mod cache {
 		println!("Elapsed: {:.2?}", elapsed);
 	}
 
+	#[test]
+	fn cursor_iter() {
+		let cache = new_cache!().unwrap();
+
+		let mut count = 0;
+		let mut ver_count = 0;
+		let mut pkgs = cache.pkg_cursor();
+		while let Some(pkg) = pkgs.next() {
+			count += 1;
+
+			let mut versions = unsafe { pkg.versions() }.raw_cursor();
+			while let Some(ver) = versions.next() {
+				assert_eq!(pkg.index(), unsafe { ver.parent_pkg() }.index());
+				ver_count += 1;
+			}
+		}
+
+		// Calling next after the end should not step past it.
+		assert!(pkgs.next().is_none());
+		assert_eq!(count, cache.iter().count());
+		assert_eq!(
+			ver_count,
+			cache
+				.iter()
+				.map(|pkg| pkg.versions().count())
+				.sum::<usize>()
+		);
+	}
+
+	#[test]
+	fn snapshot() {
+		let cache = new_cache!().unwrap();
+		let snapshot = cache.snapshot();
+
+		assert_eq!(snapshot.len(), cache.iter().count());
+		for row in 0..snapshot.len() {
+			let pkg = snapshot.package(row);
+			assert_eq!(snapshot.name(row), pkg.name());
+			assert_eq!(snapshot.arch(row), pkg.arch());
+			assert_eq!(
+				snapshot.flags(row) & StateFlags::Installed != 0,
+				pkg.is_installed()
+			);
+			assert_eq!(
+				snapshot.flags(row) & StateFlags::Upgradable != 0,
+				pkg.is_upgradable()
+			);
+			assert_eq!(
+				snapshot.columns().current_ver[row],
+				pkg.installed().map_or(0, |ver| ver.index())
+			);
+		}
+
+		assert!(snapshot
+			.rows_with(StateFlags::Installed)
+			.all(|row| snapshot.package(row).is_installed()));
+	}
+
+	#[test]
+	fn threaded_view() {
+		let mut cache = new_cache!().unwrap();
+		let expected = cache.iter().count();
+		let view = cache.view();
+
+		let counts: Vec<usize> = std::thread::scope(|s| {
+			let handles: Vec<_> = (0..4)
+				.map(|_| {
+					s.spawn(|| {
+						let mut count = 0;
+						let mut pkgs = view.pkg_cursor();
+						while let Some(pkg) = pkgs.next() {
+							view.state_flags(pkg);
+							count += 1;
+						}
+						count
+					})
+				})
+				.collect();
+			handles.into_iter().map(|h| h.join().unwrap()).collect()
+		});
+		assert!(counts.iter().all(|count| *count == expected));
+
+		let records = std::thread::scope(|s| {
+			s.spawn(|| {
+				let apt = view.find_pkg("apt").unwrap();
+				let cand = view.candidate(&apt).unwrap();
+				let records = view.records();
+				let file = unsafe { cand.version_files() };
+				records.ver_lookup(&file).get_field("Package".to_string())
+			})
+			.join()
+			.unwrap()
+		});
+		assert_eq!(records.as_deref(), Some("apt"));
+
+		// Packages found through the view can be moved to another thread.
+		let apt = view.find_pkg("apt").unwrap();
+		let name = std::thread::scope(|s| s.spawn(move || apt.name().to_string()).join().unwrap());
+		assert_eq!(name, "apt");
+	}
+
+	#[test]
+	fn parallel_scan() {
+		let mut cache = new_cache!().unwrap();
+		let names: Vec<String> = cache.iter().map(|pkg| pkg.fullname(false)).collect();
+		let view = cache.view();
+
+		// Results come back in cache order whatever the thread count.
+		for threads in [1, 3, 8] {
+			let par_names = view
+				.par_packages()
+				.threads(threads)
+				.chunk_size(100)
+				.filter_map(|pkg| Some(pkg.fullname(false)));
+			assert_eq!(par_names, names);
+		}
+
+		let count = view
+			.par_packages()
+			.map_reduce(|| 0, |count, _| count + 1, |a, b| a + b);
+		assert_eq!(count, names.len());
+
+		let seen = std::sync::atomic::AtomicUsize::new(0);
+		view.par_packages().for_each(|_| {
+			seen.fetch_add(1, std::sync::atomic::Ordering::Relaxed);
+		});
+		assert_eq!(seen.into_inner(), names.len());
+	}
+
+	#[test]
+	fn fast_open() {
+		let cache = new_cache!().unwrap();
+		let fast = Cache::new_fast::<&str>(&[]).unwrap();
+		assert_eq!(fast.fingerprint(), cache.fingerprint());
+		assert_eq!(fast.iter().count(), cache.iter().count());
+
+		// Local files always take the regular path.
+		let fast = Cache::new_fast(&["tests/files/cache/apt.deb"]).unwrap();
+		assert!(fast.get("apt").unwrap().get_version("5000:1.0.0").is_some());
+	}
+
+	#[test]
+	fn dep_graph() {
+		let cache = new_cache!().unwrap();
+		let graph = cache.dep_graph();
+		assert_eq!(graph.len(), cache.iter().count());
+
+		let apt = cache.get("apt").unwrap();
+		assert_eq!(cache.package_by_id(apt.id()).unwrap(), apt);
+
+		// Every dependency of the candidate is an edge flagged as such.
+		let cand = apt.candidate().unwrap();
+		let filter = DepFilter::all().candidate();
+		let targets: Vec<u32> = graph
+			.depends(apt.id())
+			.filter(|edge| filter.matches(edge))
+			.map(|edge| edge.id)
+			.collect();
+		for dep in cand.depends_map().values().flatten() {
+			for base in dep.iter() {
+				assert!(targets.contains(&base.target_package().id()));
+			}
+		}
+
+		// Reverse edges mirror the forward ones.
+		for edge in graph.depends(apt.id()) {
+			assert!(graph.rdepends(edge.id).any(|rev| rev.id == apt.id()));
+		}
+
+		let depends = DepFilter::types(&[DepType::Depends, DepType::PreDepends]);
+		let closure = graph.closure([apt.id()], Direction::Forward, &depends);
+		for edge in graph.depends(apt.id()).filter(|edge| depends.matches(edge)) {
+			assert!(closure.contains(&edge.id));
+		}
+	}
+
 	#[test]
 	fn with_debs() {
 		let cache = new_cache!(&[
@@ -228,6 +406,14 @@ mod cache {
 			for dep in deps.iter() {
 				// Apt Dependencies should have targets
 				assert!(dep.all_targets().first().is_some());
+
+				// The lazy targets match what apt's AllTargets returns.
+				let lazy: Vec<u64> = dep.targets().map(|ver| ver.index()).collect();
+				let listed: Vec<u64> = unsafe { dep.ptr.all_targets() }
+					.iter()
+					.map(|ver| ver.index())
+					.collect();
+				assert_eq!(lazy, listed);
 			}
 		}
 		assert!(cand.recommends().is_some());
@@ -543,6 +729,88 @@ mod cache {
 		assert!(apt_ver != dpkg_ver);
 	}
 
+	#[test]
+	fn refresh() {
+		let mut cache = new_cache!().unwrap();
+		let count = cache.iter().count();
+		let version = cache
+			.get("apt")
+			.unwrap()
+			.candidate()
+			.unwrap()
+			.version()
+			.to_string();
+
+		cache.get("apt").unwrap().mark_delete(false);
+		assert!(cache.depcache().delete_count() > 0);
+		// Build the lazy parts so they have to be thrown away.
+		cache.dep_graph();
+		cache.find_version(&format!("apt={version}")).unwrap();
+
+		cache.refresh().unwrap();
+		assert_eq!(cache.depcache().delete_count(), 0);
+		assert!(!cache.get("apt").unwrap().marked_delete());
+		assert_eq!(cache.iter().count(), count);
+		assert_eq!(cache.dep_graph().len(), count);
+
+		let ver = cache.find_version(&format!("apt={version}")).unwrap();
+		assert_eq!(ver.version(), version);
+
+		// A cache opened with local files keeps them.
+		let mut cache = new_cache!(&["tests/files/cache/apt.deb"]).unwrap();
+		assert!(cache
+			.get("apt")
+			.unwrap()
+			.get_version("5000:1.0.0")
+			.is_some());
+		cache.refresh().unwrap();
+		assert!(cache
+			.get("apt")
+			.unwrap()
+			.get_version("5000:1.0.0")
+			.is_some());
+
+		// When the new cache can't be opened the old one is still there.
+		let deb = std::env::temp_dir().join("rust-apt-test-refresh.deb");
+		std::fs::copy("tests/files/cache/apt.deb", &deb).unwrap();
+		let mut cache = new_cache!(&[deb.to_str().unwrap()]).unwrap();
+		std::fs::remove_file(&deb).unwrap();
+		assert!(cache.refresh().is_err());
+		assert!(cache
+			.get("apt")
+			.unwrap()
+			.get_version("5000:1.0.0")
+			.is_some());
+	}
+
+	#[test]
+	fn find_versions() {
+		let cache = new_cache!().unwrap();
+		let pkg = cache.get("apt").unwrap();
+		let candidate = pkg.candidate().unwrap();
+
+		let native = format!("apt={}", candidate.version());
+		let with_arch = format!("apt:{}={}", pkg.arch(), candidate.version());
+		let specs = [
+			native.as_str(),
+			with_arch.as_str(),
+			"apt=0.0-missing",
+			"apt",
+		];
+
+		let found = cache.find_versions(&specs);
+		assert_eq!(found.len(), specs.len());
+		assert_eq!(found[0].as_ref().unwrap(), &candidate);
+		assert_eq!(found[1].as_ref().unwrap().parent().name(), "apt");
+		assert!(found[2].is_none());
+		assert!(found[3].is_none());
+
+		for ver in pkg.versions() {
+			let spec = format!("apt={}", ver.version());
+			assert_eq!(cache.find_version(&spec).unwrap().version(), ver.version());
+		}
+	}
+
 	#[test]
 	// This test relies on 'neofetch' and 'gsasl-common' not being installed.
 	fn good_resolution() {
@@ -558,6 +826,38 @@ mod cache {
 		assert!(pkg2.marked_install())
 	}
 
+	#[test]
+	fn reset_resolver() {
+		let mut cache = new_cache!().unwrap();
+
+		{
+			let pkg = cache.get("neofetch").unwrap();
+			pkg.mark_install(false, true);
+			pkg.protect();
+		}
+		cache.resolve(false).unwrap();
+		assert!(cache.get("neofetch").unwrap().marked_install());
+
+		// The marks stay, only the protected packages are gone.
+		cache.reset_resolver();
+		assert!(cache.get("neofetch").unwrap().marked_install());
+		cache.resolve(false).unwrap();
+		assert_eq!(cache.depcache().broken_count(), 0);
+	}
+
+	#[test]
+	fn op_stats() {
+		let cache = new_cache!().unwrap();
+		let stats = cache.upgrade_with_stats(Upgrade::FullUpgrade).unwrap();
+
+		assert!(!stats.phases.is_empty());
+		assert!(stats.phases.iter().map(|p| p.elapsed).sum::<Duration>() <= stats.total);
+		assert_eq!(stats.after, cache.depcache().mark_counts());
+
+		let stats = cache.resolve_with_stats(false).unwrap();
+		assert_eq!(stats.before, stats.after);
+	}
+
 	// For now `zeek` has broken dependencies so the resolver errors.
 	// If this test fails, potentially find a reason.
 	#[test]
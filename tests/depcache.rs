@@ -1,6 +1,6 @@
 mod depcache {
 	use rust_apt::cache::Upgrade;
-	use rust_apt::new_cache;
+	use rust_apt::{new_cache, Mark, StateFlags};
 
 	#[test]
 	fn mark_reinstall() {
@@ -25,6 +25,185 @@ mod depcache {
 		action_group.pin_mut().release();
 	}
 
+	#[test]
+	fn checkpoint_rollback() {
+		let cache = new_cache!().unwrap();
+		let depcache = cache.depcache();
+		let before = (
+			depcache.install_count(),
+			depcache.delete_count(),
+			depcache.broken_count(),
+		);
+		let checkpoint = depcache.checkpoint();
+
+		// Nothing has changed yet.
+		assert_eq!(depcache.rollback(&checkpoint).unwrap(), 0);
+
+		let apt = cache.get("apt").unwrap();
+		apt.mark_delete(true);
+		apt.mark_reinstall(false);
+		assert!(depcache.delete_count() > before.1);
+
+		assert!(depcache.rollback(&checkpoint).unwrap() > 0);
+		assert!(!apt.marked_delete());
+		assert_eq!(
+			(
+				depcache.install_count(),
+				depcache.delete_count(),
+				depcache.broken_count(),
+			),
+			before
+		);
+
+		// Checkpoints can be used again.
+		apt.mark_delete(false);
+		depcache.rollback(&checkpoint).unwrap();
+		assert!(!apt.marked_delete());
+	}
+
+	#[test]
+	fn mark_many() {
+		let cache = new_cache!().unwrap();
+		let apt = cache.get("apt").unwrap();
+		let dpkg = cache.get("dpkg").unwrap();
+
+		let done = cache.depcache().mark_many(&[
+			(&apt, Mark::ReInstall(true)),
+			(&dpkg, Mark::Delete { purge: false }),
+			(&dpkg, Mark::Keep),
+		]);
+		assert_eq!(done.len(), 3);
+		assert!(apt.marked_reinstall());
+		assert!(!dpkg.marked_delete());
+	}
+
+	#[test]
+	fn memoized_state() {
+		let cache = new_cache!().unwrap();
+		let depcache = cache.depcache();
+		let apt = cache.get("apt").unwrap();
+
+		let flags = apt.state_flags();
+		assert_eq!(flags, depcache.state_flags(&apt));
+		assert_eq!(flags & StateFlags::Installed != 0, apt.is_installed());
+
+		// Reading the state doesn't change the generation.
+		let generation = depcache.generation();
+		assert!(!apt.marked_delete());
+		assert_eq!(depcache.generation(), generation);
+
+		// Marks through another handle to the same package are still seen.
+		cache.get("apt").unwrap().mark_delete(false);
+		assert!(depcache.generation() > generation);
+		assert!(apt.marked_delete());
+		assert_ne!(apt.state_flags(), flags);
+
+		cache.depcache().clear_marked().unwrap();
+		assert!(!apt.marked_delete());
+		assert_eq!(apt.state_flags(), flags);
+	}
+
+	#[test]
+	fn memoized_state_batches() {
+		let cache = new_cache!().unwrap();
+		let depcache = cache.depcache();
+		let apt = cache.get("apt").unwrap();
+		let dpkg = cache.get("dpkg").unwrap();
+		let checkpoint = depcache.checkpoint();
+
+		// Both flags are read, and kept, before anything is marked.
+		let (apt_flags, dpkg_flags) = (apt.state_flags(), dpkg.state_flags());
+		assert!(!apt.marked_reinstall());
+		assert!(!dpkg.marked_delete());
+
+		let generation = depcache.generation();
+		depcache.mark_many(&[
+			(&apt, Mark::ReInstall(true)),
+			(&dpkg, Mark::Delete { purge: false }),
+		]);
+		assert!(depcache.generation() > generation);
+		assert!(apt.marked_reinstall());
+		assert!(dpkg.marked_delete());
+
+		let generation = depcache.generation();
+		depcache.rollback(&checkpoint).unwrap();
+		assert!(depcache.generation() > generation);
+		assert!(!apt.marked_reinstall());
+		assert!(!dpkg.marked_delete());
+		assert_eq!(apt.state_flags(), apt_flags);
+		assert_eq!(dpkg.state_flags(), dpkg_flags);
+	}
+
+	#[test]
+	fn changed_packages() {
+		let cache = new_cache!().unwrap();
+		let depcache = cache.depcache();
+		assert_eq!(cache.get_changes(false).count(), 0);
+
+		cache.get("apt").unwrap().mark_reinstall(true);
+		cache.get("dpkg").unwrap().mark_delete(false);
+		let names: Vec<String> = cache
+			.get_changes(true)
+			.map(|pkg| pkg.name().to_string())
+			.collect();
+		assert!(names.contains(&"apt".to_string()));
+		assert!(names.contains(&"dpkg".to_string()));
+
+		// Nothing was marked in between, so this is the same list.
+		assert_eq!(depcache.changed_packages(), depcache.changed_packages());
+
+		// Every changed package is found, the same as checking them all.
+		let scanned = cache
+			.iter()
+			.filter(|pkg| {
+				pkg.marked_install()
+					|| pkg.marked_delete()
+					|| pkg.marked_upgrade()
+					|| pkg.marked_downgrade()
+					|| pkg.marked_reinstall()
+			})
+			.count();
+		assert_eq!(cache.get_changes(false).count(), scanned);
+
+		depcache.clear_marked().unwrap();
+		assert_eq!(cache.get_changes(false).count(), 0);
+	}
+
+	#[test]
+	fn fork_depcache() {
+		let mut cache = new_cache!().unwrap();
+		cache.get("apt").unwrap().mark_reinstall(true);
+
+		let view = cache.view();
+		let apt = view.find_pkg("apt").unwrap();
+		// Forks start with the marks of the shared DepCache.
+		let fork = view.fork_depcache().unwrap();
+		assert!(fork.marked_reinstall(&apt));
+
+		// And keep their own marks to themselves.
+		fork.mark_reinstall(&apt, false);
+		assert!(!fork.marked_reinstall(&apt));
+		drop(fork);
+		assert!(view.state_flags(&apt) & StateFlags::ReInstall != 0);
+
+		let installed: Vec<u32> = std::thread::scope(|s| {
+			let workers: Vec<_> = [Upgrade::FullUpgrade, Upgrade::SafeUpgrade]
+				.into_iter()
+				.map(|upgrade| {
+					let fork = view.fork_depcache().unwrap();
+					s.spawn(move || {
+						fork.upgrade(upgrade).unwrap();
+						fork.resolve(false).unwrap();
+						fork.install_count()
+					})
+				})
+				.collect();
+			workers.into_iter().map(|w| w.join().unwrap()).collect()
+		});
+		// A safe upgrade never does more than a full one.
+		assert!(installed[1] <= installed[0]);
+	}
+
 	// Make a test for getting the candidate after you set a candidate.
 	// Make sure it's the expected version.
 	// We had to change to getting the candidate from the depcache.
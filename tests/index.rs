@@ -0,0 +1,66 @@
+mod index {
+	use rust_apt::index::FieldIndex;
+	use rust_apt::new_cache;
+	use rust_apt::records::RecordField;
+
+	#[test]
+	fn source_index() {
+		let cache = new_cache!().unwrap();
+		let index = FieldIndex::build(&cache, RecordField::Source);
+
+		let apt: Vec<_> = index.get("apt").collect();
+		assert!(!apt.is_empty());
+		assert!(apt.iter().all(|ver| ver.source_name() == "apt"));
+		assert!(apt.iter().any(|ver| ver.parent().name() == "apt"));
+
+		assert!(index.get("this-source-does-not-exist").next().is_none());
+		assert!(index.keys().any(|key| key == "apt"));
+	}
+
+	#[test]
+	fn saved_index() {
+		let cache = new_cache!().unwrap();
+		let path = std::env::temp_dir().join("rust-apt-test.maintainer.idx");
+
+		let built = FieldIndex::build(&cache, RecordField::Maintainer);
+		built.save(&path).unwrap();
+
+		let opened = FieldIndex::open(&cache, RecordField::Maintainer, &path).unwrap();
+		assert_eq!(built.len(), opened.len());
+
+		let maintainer = "APT Development Team <deity@lists.debian.org>";
+		let mut names: Vec<_> = opened
+			.get(maintainer)
+			.map(|ver| ver.parent().name().to_string())
+			.collect();
+		names.sort();
+		assert!(names.binary_search(&"apt".to_string()).is_ok());
+
+		// An index for one field can't be opened as another.
+		assert!(FieldIndex::open(&cache, RecordField::Section, &path).is_err());
+		std::fs::remove_file(path).unwrap();
+	}
+
+	#[test]
+	fn corrupt_index() {
+		let cache = new_cache!().unwrap();
+		let path = std::env::temp_dir().join("rust-apt-test.corrupt.idx");
+		FieldIndex::build(&cache, RecordField::Source)
+			.save(&path)
+			.unwrap();
+
+		// Point the first version at something that isn't a version. The
+		// fingerprint still matches, so only the version check catches it.
+		let mut data = std::fs::read(&path).unwrap();
+		let versions = u32::from_le_bytes(data[28..32].try_into().unwrap()) as usize;
+		data[versions..versions + 4].copy_from_slice(&u32::MAX.to_le_bytes());
+		std::fs::write(&path, &data).unwrap();
+
+		assert!(FieldIndex::open(&cache, RecordField::Source, &path).is_err());
+
+		// Truncated files are thrown away as well.
+		std::fs::write(&path, &data[..data.len() / 2]).unwrap();
+		assert!(FieldIndex::open(&cache, RecordField::Source, &path).is_err());
+		std::fs::remove_file(path).unwrap();
+	}
+}
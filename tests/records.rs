@@ -28,4 +28,140 @@ mod records {
 		// This should be the same as what the Hash accessors will give.
 		assert_eq!(cand.get_record("SHA256"), cand.sha256());
 	}
+
+	#[test]
+	fn borrowed_fields() {
+		let cache = new_cache!().unwrap();
+
+		let cand = cache.get("apt").unwrap().candidate().unwrap();
+		let mut reader = cache.record_reader();
+		assert!(reader.lookup(&cand));
+
+		for field in [
+			RecordField::Maintainer,
+			RecordField::Version,
+			RecordField::Depends,
+			RecordField::SHA256,
+			RecordField::Homepage,
+		] {
+			let owned = cand.get_record(field);
+			let borrowed = reader.get_field(field).map(|value| value.to_string());
+			assert_eq!(owned, borrowed);
+		}
+
+		// Moving to another record needs the fields to be dropped first.
+		let other = cache.get("dpkg").unwrap().candidate().unwrap();
+		assert!(reader.lookup(&other));
+		assert_eq!(
+			reader.get_field(RecordField::Package),
+			Some(other.parent().name())
+		);
+		assert!(reader.record().unwrap().contains("Package: dpkg"));
+	}
+
+	#[test]
+	fn reader_send() {
+		let cache = new_cache!().unwrap();
+
+		let cand = cache.get("apt").unwrap().candidate().unwrap();
+		let mut reader = cache.record_reader();
+		assert!(reader.lookup(&cand));
+
+		let maintainer = cand.get_record(RecordField::Maintainer);
+		let moved = std::thread::scope(|scope| {
+			scope
+				.spawn(move || reader.get_field(RecordField::Maintainer).map(String::from))
+				.join()
+				.unwrap()
+		});
+		assert_eq!(moved, maintainer);
+	}
+
+	#[test]
+	fn batch_fields() {
+		let cache = new_cache!().unwrap();
+
+		let cand = cache.get("apt").unwrap().candidate().unwrap();
+		let names = [
+			RecordField::Maintainer,
+			RecordField::Homepage,
+			RecordField::Filename,
+			RecordField::SHA256,
+			RecordField::Size,
+			RecordField::Depends,
+		];
+
+		let fields = cand.get_records(&names).unwrap();
+		assert_eq!(fields.len(), names.len());
+
+		for (name, value) in names.iter().zip(fields.iter()) {
+			assert_eq!(value, &cand.get_record(*name));
+		}
+
+		let mut reader = cache.record_reader();
+		assert!(reader.lookup(&cand));
+		let borrowed = reader.get_fields(&names).unwrap();
+		assert_eq!(borrowed.len(), names.len());
+
+		for (value, owned) in borrowed.iter().zip(fields.iter()) {
+			assert_eq!(value, owned.as_deref());
+		}
+		assert!(borrowed.get(names.len()).is_none());
+	}
+
+	#[test]
+	fn sorted_lookup() {
+		let cache = new_cache!().unwrap();
+
+		let versions: Vec<_> = cache.iter().filter_map(|pkg| pkg.candidate()).collect();
+
+		let mut last = (0, 0);
+		let mut count = 0;
+		cache.records().for_each_sorted(&versions, |ver, records| {
+			let position = ver.version_files().next().unwrap().position();
+			assert!(position >= last);
+			last = position;
+
+			assert_eq!(
+				records
+					.get_field(RecordField::Package.to_string())
+					.as_deref(),
+				Some(ver.parent().name())
+			);
+			count += 1;
+		});
+		assert_eq!(count, versions.len());
+	}
+
+	#[test]
+	fn missing_fields() {
+		let cache = new_cache!().unwrap();
+
+		let cand = cache.get("apt").unwrap().candidate().unwrap();
+		let records = cand.version_files().next().unwrap().lookup();
+
+		// Missing values come back empty instead of as an error.
+		assert!(records
+			.get_field(RecordField::Homepage.to_string())
+			.is_none());
+		let mut reader = cache.record_reader();
+		assert!(reader.lookup(&cand));
+		assert!(reader.get_field(RecordField::Homepage).is_none());
+		assert!(records
+			.hash_find("This-Hash-Does-Not-Exist".to_string())
+			.is_none());
+		assert_eq!(cand.section_or_empty(), cand.section().unwrap_or_default());
+		assert_eq!(
+			cand.priority_str_or_empty(),
+			cand.priority_str().unwrap_or_default()
+		);
+
+		for dep in cand.depends_map().values().flatten() {
+			for base in dep.iter() {
+				// The wrappers agree with the raw methods that throw.
+				assert_eq!(base.comp_type(), (**base).comp_type().ok());
+				assert_eq!(base.version(), (**base).target_ver().ok());
+			}
+		}
+	}
 }
@@ -1,7 +1,9 @@
 mod root {
 	use rust_apt::config::Config;
 	use rust_apt::new_cache;
-	use rust_apt::progress::{AcquireProgress, DynAcquireProgress, InstallProgress};
+	use rust_apt::progress::{
+		AcquireCounters, AcquireProgress, DynAcquireProgress, InstallProgress,
+	};
 	use rust_apt::raw::{AcqTextStatus, ItemDesc, ItemState, PkgAcquire};
 	use rust_apt::util::*;
 
@@ -95,6 +97,17 @@ mod root {
 		// Test a new impl for AcquireProgress
 		let mut progress = AcquireProgress::new(Progress {});
 		cache.update(&mut progress).unwrap();
+
+		let cache = new_cache!().unwrap();
+
+		// Test the counting progress
+		let counters = AcquireCounters::new();
+		let mut progress = AcquireProgress::counting(counters.clone());
+		cache.update(&mut progress).unwrap();
+
+		let stats = counters.snapshot();
+		assert!(!stats.running);
+		assert!(stats.hits + stats.done + stats.failed > 0);
 	}
 
 	#[test]
@@ -0,0 +1,40 @@
+mod stats {
+	use rust_apt::new_cache;
+	use rust_apt::stats::{reset_stats, stats, Stats};
+	use rust_apt::tagfile::AptTagFile;
+
+	#[test]
+	fn counters() {
+		let cache = new_cache!().unwrap();
+		reset_stats();
+
+		let pkg = cache.get("apt").unwrap();
+		pkg.name();
+		let ver = pkg.candidate().unwrap();
+		assert!(ver.get_record("This-Field-Does-Not-Exist").is_none());
+
+		let stats = stats();
+		if !Stats::enabled() {
+			assert_eq!(stats.total_calls(), 0);
+			assert_eq!(stats.total_allocations(), 0);
+			assert_eq!(stats.total_exceptions(), 0);
+			return;
+		}
+
+		let has = |list: &[(String, u64)], name: &str| list.iter().any(|(n, _)| n == name);
+		assert!(has(&stats.calls, "PkgIterator::name"));
+		assert!(has(&stats.allocations, "VerIterator"));
+		// A missing field is not an error, so nothing was thrown.
+		assert_eq!(stats.total_exceptions(), 0);
+		assert!(stats.calls.windows(2).all(|w| w[0].1 >= w[1].1));
+
+		reset_stats();
+		assert_eq!(stats().total_calls(), 0);
+
+		// The throw is in handle_errors, but counts under the call that used it.
+		assert!(AptTagFile::open("/rust-apt/does/not/exist").is_err());
+		let stats = stats();
+		assert!(has(&stats.exceptions, "open_tagfile"));
+		assert!(!has(&stats.exceptions, "handle_errors"));
+	}
+}
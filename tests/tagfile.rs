@@ -1,5 +1,8 @@
 mod tagfile {
-	use rust_apt::tagfile::{self, TagSection};
+	use std::fs::File;
+	use std::io::BufReader;
+
+	use rust_apt::tagfile::{self, AptTagFile, TagFileReader, TagSection, TagSectionRef};
 
 	#[test]
 	fn correct() {
@@ -48,4 +51,99 @@ mod tagfile {
 			"\n\tAll my homies know that tabs be superior.\n\t   Why not just use both?"
 		);
 	}
+
+	#[test]
+	fn borrowed() {
+		let control_file = include_str!("files/tagfile/correct.control");
+		let dpkg_status = include_str!("/var/lib/dpkg/status");
+
+		for content in [control_file, dpkg_status] {
+			let owned = tagfile::parse_tagfile(content).unwrap();
+			let borrowed: Vec<TagSectionRef> = tagfile::sections(content)
+				.collect::<Result<_, _>>()
+				.unwrap();
+			assert_eq!(owned.len(), borrowed.len());
+
+			for (owned, borrowed) in owned.iter().zip(&borrowed) {
+				assert_eq!(owned.hashmap().len(), borrowed.len());
+				for (key, value) in borrowed.iter() {
+					// Only an empty value differs.
+					let expected = owned.get(key).unwrap();
+					assert!(value == expected || (value.is_empty() && expected == "\n"));
+				}
+			}
+		}
+
+		let section = TagSectionRef::new("Package: pkg\nMulti:\n  one\n  two\n").unwrap();
+		assert_eq!(section.get("Package"), Some("pkg"));
+		assert_eq!(section.get("Multi"), Some("\n  one\n  two"));
+		assert_eq!(section.get_default("Missing", "none"), "none");
+		assert_eq!(section.to_tag_section().get("Package").unwrap(), "pkg");
+
+		// Errors have the line number in the whole file.
+		let err = tagfile::sections("A: b\n\n\nC: d\n  e\nbad\n")
+			.find_map(Result::err)
+			.unwrap();
+		assert_eq!(err.line, Some(6));
+		assert!(TagSectionRef::new("  No key").is_err());
+	}
+
+	#[test]
+	fn reader() {
+		// Read at runtime, the status can change between building and running the tests.
+		let dpkg_status = std::fs::read_to_string("/var/lib/dpkg/status").unwrap();
+		let expected: Vec<String> = tagfile::sections(&dpkg_status)
+			.map(|section| section.unwrap().get_default("Package", "").to_string())
+			.collect();
+
+		let file = File::open("/var/lib/dpkg/status").unwrap();
+		let mut reader = TagFileReader::new(BufReader::new(file));
+		let mut packages = Vec::new();
+		while let Some(section) = reader.next_section() {
+			packages.push(section.unwrap().get_default("Package", "").to_string());
+		}
+		assert_eq!(packages, expected);
+
+		let mut reader = TagFileReader::new("\nA: b\n\n\nC: d\nbad\n".as_bytes());
+		assert_eq!(reader.next_section().unwrap().unwrap().get("A"), Some("b"));
+		assert_eq!(reader.next_section().unwrap().unwrap_err().line, Some(6));
+		assert!(reader.next_section().is_none());
+	}
+
+	#[test]
+	fn apt_tagfile() {
+		// Read at runtime, the status can change between building and running the tests.
+		let dpkg_status = std::fs::read_to_string("/var/lib/dpkg/status").unwrap();
+		let expected: Vec<TagSectionRef> = tagfile::sections(&dpkg_status)
+			.collect::<Result<_, _>>()
+			.unwrap();
+
+		let mut file = AptTagFile::open("/var/lib/dpkg/status").unwrap();
+		let mut count = 0;
+		while let Some(section) = file.next_section().unwrap() {
+			let borrowed = &expected[count];
+			assert_eq!(section.get("Package"), borrowed.get("Package"));
+			assert_eq!(section.get("Version"), borrowed.get("Version"));
+			assert_eq!(section.len(), borrowed.len());
+			assert!(section.exists("Status"));
+			assert!(section.get("Not-A-Key-In-The-Status-File").is_none());
+			count += 1;
+		}
+		assert_eq!(count, expected.len());
+
+		// Compressed files are read the same as plain ones.
+		let mut file = AptTagFile::open("tests/files/tagfile/correct.control.gz").unwrap();
+		let section = file.next_section().unwrap().unwrap();
+		assert_eq!(section.get("Package"), Some("pkg1"));
+		assert_eq!(
+			section.get("Multi-Line"),
+			Some("Wow\n  This is\n  Multiple lines!")
+		);
+		assert_eq!(section.to_section_ref().unwrap().len(), 5);
+		let section = file.next_section().unwrap().unwrap();
+		assert_eq!(section.get("Package"), Some("pkg2"));
+		assert!(file.next_section().unwrap().is_none());
+
+		assert!(AptTagFile::open("tests/files/tagfile/does-not-exist").is_err());
+	}
 }
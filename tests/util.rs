@@ -12,4 +12,30 @@ mod util {
 		assert_eq!(Ordering::Equal, util::cmp_versions(ver1, ver1));
 		assert_eq!(Ordering::Greater, util::cmp_versions(ver2, ver1));
 	}
+
+	#[test]
+	fn version_key() {
+		let versions = [
+			"1.0~~", "1.0~", "1.0~rc1", "1.0", "1.00", "1.0-0", "1.0-1", "1.0-1.1", "1.0a",
+			"1.0+b1", "1.0.1", "1.2", "1.10", "01:0.1", "1:0.9", "1:1.0~", "2:0", "0:1.0", "a",
+			"a0", "1.0-a", "1.0-rc~1", "1.0-", "",
+		];
+
+		for a in versions {
+			for b in versions {
+				assert_eq!(
+					util::VersionKey::new(a).cmp(&util::VersionKey::new(b)),
+					util::cmp_versions(a, b),
+					"{a} <=> {b}"
+				);
+			}
+		}
+	}
+
+	#[test]
+	fn sort_by_version() {
+		let mut list = ["2.10", "2.6.1", "2.6.1~bpo1", "1:0.1", "2.6"];
+		util::sort_by_version(&mut list, |ver| ver);
+		assert_eq!(list, ["2.6", "2.6.1~bpo1", "2.6.1", "2.10", "1:0.1"]);
+	}
 }